@@ -0,0 +1,855 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Bench.cpp
+ Description:   Offline benchmarks, run from the command line instead of the
+                drawing loop.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "Bench.h"
+#include "Stroke.h"
+#include "Pointer.h"
+#include "Filter.h"
+#include "Fusion.h"
+#include "Drift.h"
+#include "Emg.h"
+#include "Gesture.h"
+#include "Options.h"
+#include "FileSource.h"
+#include "SyntheticSource.h"
+#include "Log.h"
+
+#include <cstdio>
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//keeps results alive so the timed loops aren't optimized away
+static volatile float sink;
+
+const int BENCH_WIDTH = 1280;
+const int BENCH_HEIGHT = 720;
+
+//the loop main used before Stroke, kept here for comparison
+static void legacySegment(SDL_Surface * surface, int x, int y, int lastX, int lastY,
+    int width, Uint32 color) {
+  SDL_Rect rect2 = {x, y, width, width};
+
+  while(rect2.x != lastX || rect2.y != lastY) {
+    SDL_FillRect(surface, &rect2, color);
+    if(rect2.x < lastX) rect2.x += 1;
+    else if(rect2.x > lastX) rect2.x -= 1;
+
+    if(rect2.y < lastY) rect2.y += 1;
+    else if(rect2.y > lastY) rect2.y -= 1;
+  }
+}
+
+static double nsPer(Clock::time_point begin, int count) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / count;
+}
+
+int benchStroke() {
+  SDL_Surface * surface = SDL_CreateRGBSurfaceWithFormat(0, BENCH_WIDTH, BENCH_HEIGHT,
+      32, SDL_PIXELFORMAT_ARGB8888);
+
+  if(surface == NULL) {
+    printf("Bench surface could not be created! SDL Error: %s\n", SDL_GetError());
+    return -1;
+  }
+
+  Canvas canvas;
+  if(canvas.init(BENCH_WIDTH, BENCH_HEIGHT, SDL_PIXELFORMAT_ARGB8888)) {
+    SDL_FreeSurface(surface);
+    return -1;
+  }
+
+  Stroke stroke;
+  const int lengths[] = {2, 5, 20, 80, 300};
+  const int widths[] = {1, 4, 9};
+  const int segments = 20000;
+
+  printf("%6s %6s %14s %14s %8s\n", "length", "width", "legacy ns/seg", "stroke ns/seg", "speedup");
+
+  for(int w = 0; w < 3; w++) {
+    for(int l = 0; l < 5; l++) {
+      int len = lengths[l];
+      int width = widths[w];
+
+      //segments at a spread of angles so both axes get exercised
+      Clock::time_point begin = Clock::now();
+      for(int n = 0; n < segments; n++) {
+        float a = n * 0.618f;
+        int x0 = BENCH_WIDTH / 2 + (n % 97) - 48;
+        int y0 = BENCH_HEIGHT / 2 + (n % 89) - 44;
+        int x1 = x0 + (int) (len * std::cos(a));
+        int y1 = y0 + (int) (len * std::sin(a));
+        legacySegment(surface, x1, y1, x0, y0, width, n);
+      }
+      double legacy = nsPer(begin, segments);
+
+      begin = Clock::now();
+      for(int n = 0; n < segments; n++) {
+        float a = n * 0.618f;
+        int x0 = BENCH_WIDTH / 2 + (n % 97) - 48;
+        int y0 = BENCH_HEIGHT / 2 + (n % 89) - 44;
+        int x1 = x0 + (int) (len * std::cos(a));
+        int y1 = y0 + (int) (len * std::sin(a));
+        stroke.segment(canvas, x0, y0, x1, y1, width / 2.0f, n);
+      }
+      double capsule = nsPer(begin, segments);
+
+      printf("%6d %6d %14.1f %14.1f %7.2fx\n", len, width, legacy, capsule, legacy / capsule);
+    }
+  }
+
+  //a curved swing drawn one segment per sample against one polyline per batch
+  const int batches[] = {2, 4, 16, 64};
+  const int points = 40000;
+  std::vector<StrokePoint> path;
+
+  printf("\n%6s %6s %14s %14s %8s\n", "batch", "width", "segment ns/pt", "polyline ns/pt", "speedup");
+
+  for(int w = 1; w < 3; w++) {
+    for(int b = 0; b < 4; b++) {
+      int batch = batches[b];
+      float radius = widths[w] / 2.0f;
+
+      Clock::time_point begin = Clock::now();
+      for(int n = 0; n < points; n += batch) {
+        for(int p = 0; p < batch; p++) {
+          float a0 = (n + p) * 0.02f;
+          float a1 = a0 + 0.02f;
+          stroke.segment(canvas, BENCH_WIDTH / 2 + 300 * std::cos(a0), BENCH_HEIGHT / 2 + 200 * std::sin(a0),
+              BENCH_WIDTH / 2 + 300 * std::cos(a1), BENCH_HEIGHT / 2 + 200 * std::sin(a1), radius, n);
+        }
+      }
+      double single = nsPer(begin, points);
+
+      begin = Clock::now();
+      for(int n = 0; n < points; n += batch) {
+        path.clear();
+        for(int p = 0; p <= batch; p++) {
+          float a = (n + p) * 0.02f;
+          path.push_back({BENCH_WIDTH / 2 + 300 * std::cos(a), BENCH_HEIGHT / 2 + 200 * std::sin(a), radius});
+        }
+        stroke.polyline(canvas, path, n);
+      }
+      double batched = nsPer(begin, points);
+
+      printf("%6d %6d %14.1f %14.1f %7.2fx\n", batch, widths[w], single, batched, single / batched);
+    }
+  }
+
+  //the same swing four samples a frame with the width and opacity changing
+  //along it, as --pressure emg draws it
+  const char * kinds[] = {"even", "tapered", "blended", "continued"};
+  printf("\n%10s %14s\n", "polyline", "ns/pt");
+
+  for(int kind = 0; kind < 4; kind++) {
+    bool taper = kind > 0;
+    bool blended = kind > 1;
+    bool continued = kind > 2;
+
+    Clock::time_point begin = Clock::now();
+    for(int n = 0; n < points; n += 4) {
+      path.clear();
+      for(int p = continued && n > 0 ? -1 : 0; p <= 4; p++) {
+        float a = (n + p) * 0.02f;
+        float radius = taper ? 1 + 3.5f * (1 + std::sin((n + p) * 0.05f)) : 4.5f;
+        Uint8 alpha = blended ? (Uint8) (40 + 200 * (radius - 1) / 7) : 255;
+        path.push_back({BENCH_WIDTH / 2 + 300 * std::cos(a), BENCH_HEIGHT / 2 + 200 * std::sin(a),
+            radius, alpha});
+      }
+      stroke.polyline(canvas, path, n, continued && n > 0);
+    }
+
+    printf("%10s %14.1f\n", kinds[kind], nsPer(begin, points));
+  }
+
+  SDL_FreeSurface(surface);
+  return 0;
+}
+
+//the Euler angle mapping main used before Pointer, kept here for comparison
+static void legacyMap(const float * q, float & x, float & y, float & radius) {
+  float w = q[0], qx = q[1], qy = q[2], qz = q[3];
+  float roll = std::atan2(2.0f * (w * qx + qy * qz), 1.0f - 2.0f * (qx * qx + qy * qy));
+  float pitch = std::asin(std::max(-1.0f, std::min(1.0f, 2.0f * (w * qy - qz * qx))));
+  float yaw = std::atan2(2.0f * (w * qz + qx * qy), 1.0f - 2.0f * (qy * qy + qz * qz));
+
+  int roll_w = static_cast<int>((roll + (float) M_PI) / (M_PI * 2.0f) * 1800);
+  int pitch_w = static_cast<int>((pitch + (float) M_PI / 2.0f) / M_PI * 1800);
+  int yaw_w = static_cast<int>((yaw + (float) M_PI) / (M_PI * 2.0f) * 1800);
+
+  x = (900 - yaw_w) * 5 * BENCH_WIDTH / 1800.0 + 900 * BENCH_WIDTH / 1800.0;
+  y = (900 - pitch_w) * 3 * BENCH_HEIGHT / 1800.0 + 900 * BENCH_HEIGHT / 1800.0;
+  radius = (roll_w / 200) / 2.0f;
+}
+
+int benchPointer() {
+  const int count = 1 << 16;
+  const int rounds = 50;
+
+  //an arm sweeping about in front of the screen
+  PointerBatch batch;
+  batch.resize(count);
+  std::vector<float> quats(count * 4);
+
+  for(int n = 0; n < count; n++) {
+    float yaw = 0.6f * std::sin(n * 0.001f);
+    float pitch = 0.4f * std::sin(n * 0.0013f);
+    float roll = 1.0f + 0.3f * std::sin(n * 0.0007f);
+    float cr = std::cos(roll / 2), sr = std::sin(roll / 2);
+    float cp = std::cos(pitch / 2), sp = std::sin(pitch / 2);
+    float cy = std::cos(yaw / 2), sy = std::sin(yaw / 2);
+
+    float * q = &quats[n * 4];
+    q[0] = batch.w[n] = cr * cp * cy + sr * sp * sy;
+    q[1] = batch.x[n] = sr * cp * cy - cr * sp * sy;
+    q[2] = batch.y[n] = cr * sp * cy + sr * cp * sy;
+    q[3] = batch.z[n] = cr * cp * sy - sr * sp * cy;
+  }
+
+  Clock::time_point begin = Clock::now();
+  for(int r = 0; r < rounds; r++) {
+    for(int n = 0; n < count; n++) {
+      float x, y, radius;
+      legacyMap(&quats[n * 4], x, y, radius);
+      sink = x + y + radius;
+    }
+  }
+  double legacy = nsPer(begin, count * rounds);
+
+  Pointer pointer(BENCH_WIDTH, BENCH_HEIGHT, 5, 3);
+
+  begin = Clock::now();
+  for(int r = 0; r < rounds; r++) {
+    pointer.map(batch, 0, count);
+    sink = batch.px[r] + batch.py[r] + batch.radius[r];
+  }
+  double mapped = nsPer(begin, count * rounds);
+
+  printf("%14s %14s %8s\n", "euler ns/smp", "pointer ns/smp", "speedup");
+  printf("%14.2f %14.2f %7.2fx\n", legacy, mapped, legacy / mapped);
+  return 0;
+}
+
+//screen positions of one filter setting over the replayed session
+struct Trace {
+  std::vector<double> t;
+  std::vector<float> x, y;
+};
+
+//the whole session, as fast as the source can produce it
+static bool replay(const Options & opts, std::vector<InputEvent> & events) {
+  InputSource * source;
+
+  if(opts.source == "file") {
+    FileSource * file = new FileSource(opts.file, 0);
+    if(!file->open()) {
+      printf("Unable to read %s\n", opts.file.c_str());
+      delete file;
+      return false;
+    }
+    source = file;
+  }
+  else {
+    SyntheticConfig config = opts.synthetic;
+    config.speed = 0;
+    if(config.duration <= 0)
+      config.duration = 60;
+    source = new SyntheticSource(config);
+  }
+
+  source->start();
+
+  InputEvent e;
+  while(true) {
+    bool finished = source->finished();
+    while(source->poll(e))
+      events.push_back(e);
+    if(finished)
+      break;
+    SDL_Delay(1);
+  }
+
+  source->stop();
+  delete source;
+  return !events.empty();
+}
+
+static void run(const std::vector<InputEvent> & events, int type, float minCutoff, float beta,
+    Trace & trace) {
+  OrientationFilter filter;
+  filter.type = type;
+  filter.minCutoff = minCutoff;
+  filter.beta = beta;
+
+  Pointer pointer(BENCH_WIDTH, BENCH_HEIGHT, 5, 3);
+  pointer.recenter(events[0].quat);
+
+  PointerBatch batch;
+  batch.resize(events.size());
+  trace.t.resize(events.size());
+
+  for(size_t n = 0; n < events.size(); n++) {
+    InputEvent e = events[n];
+    filter.apply(e);
+    batch.w[n] = e.quat[0];
+    batch.x[n] = e.quat[1];
+    batch.y[n] = e.quat[2];
+    batch.z[n] = e.quat[3];
+    trace.t[n] = (e.timestamp - events[0].timestamp) / 1000.0;
+  }
+
+  pointer.map(batch, 0, events.size());
+  trace.x = batch.px;
+  trace.y = batch.py;
+}
+
+//shake left after the motion, px: distance of each sample from the
+//midpoint of its neighbours
+static double jitter(const Trace & trace) {
+  double sum = 0;
+  size_t count = trace.t.size();
+  for(size_t n = 1; n + 1 < count; n++) {
+    double dx = trace.x[n] - (trace.x[n - 1] + trace.x[n + 1]) / 2;
+    double dy = trace.y[n] - (trace.y[n - 1] + trace.y[n + 1]) / 2;
+    sum += dx * dx + dy * dy;
+  }
+  return count > 2 ? std::sqrt(sum / (count - 2)) : 0;
+}
+
+//shift in ms that best lines the filtered path up with the raw one
+static double lag(const Trace & raw, const Trace & filtered) {
+  double best = 0;
+  double bestError = -1;
+
+  for(double shift = 0; shift <= 500; shift += 0.5) {
+    double error = 0;
+    size_t j = 0;
+    for(size_t n = 0; n < filtered.t.size(); n++) {
+      double at = filtered.t[n] - shift;
+      if(at < 0)
+        continue;
+      while(j + 2 < raw.t.size() && raw.t[j + 1] < at)
+        j++;
+
+      double span = raw.t[j + 1] - raw.t[j];
+      double f = span > 0 ? (at - raw.t[j]) / span : 0;
+      double dx = filtered.x[n] - (raw.x[j] + f * (raw.x[j + 1] - raw.x[j]));
+      double dy = filtered.y[n] - (raw.y[j] + f * (raw.y[j + 1] - raw.y[j]));
+      error += dx * dx + dy * dy;
+    }
+
+    if(bestError < 0 || error < bestError) {
+      bestError = error;
+      best = shift;
+    }
+  }
+  return best;
+}
+
+int benchFilter(const Options & opts) {
+  std::vector<InputEvent> all;
+  std::vector<InputEvent> events;
+  if(replay(opts, all))
+    for(size_t n = 0; n < all.size(); n++)
+      if(all[n].type == EVENT_ORIENTATION)
+        events.push_back(all[n]);
+
+  if(events.size() < 3) {
+    printf("No orientation samples to filter\n");
+    return -1;
+  }
+
+  Trace raw;
+  run(events, FILTER_NONE, 1, 0, raw);
+
+  printf("%u samples over %.1f s\n", (unsigned int) events.size(), raw.t.back() / 1000.0);
+  printf("%6s %10s %6s %10s %10s\n", "filter", "cutoff Hz", "beta", "jitter px", "lag ms");
+  printf("%6s %10s %6s %10.2f %10.1f\n", "none", "-", "-", jitter(raw), 0.0);
+
+  const float cutoffs[] = {0.5f, 1, 2, 5};
+  const float betas[] = {0.1f, 0.5f, 2};
+
+  for(int c = 0; c < 4; c++) {
+    Trace filtered;
+    run(events, FILTER_SLERP, cutoffs[c], 0, filtered);
+    printf("%6s %10.1f %6s %10.2f %10.1f\n", "slerp", cutoffs[c], "-",
+        jitter(filtered), lag(raw, filtered));
+  }
+
+  for(int c = 0; c < 4; c++) {
+    for(int b = 0; b < 3; b++) {
+      Trace filtered;
+      run(events, FILTER_EURO, cutoffs[c], betas[b], filtered);
+      printf("%6s %10.1f %6.1f %10.2f %10.1f\n", "euro", cutoffs[c], betas[b],
+          jitter(filtered), lag(raw, filtered));
+    }
+  }
+
+  return 0;
+}
+
+//mean ms between the cursor's data being taken and being replaced, over
+//the updates at timestamps t
+static double staleness(const std::vector<uint64_t> & t) {
+  double sum = 0;
+  for(size_t n = 1; n < t.size(); n++) {
+    double gap = (t[n] - t[n - 1]) / 1000.0;
+    sum += gap * gap / 2;
+  }
+  return t.size() > 1 ? sum / ((t.back() - t.front()) / 1000.0) : 0;
+}
+
+int benchFusion(const Options & opts) {
+  std::vector<InputEvent> events;
+  replay(opts, events);
+
+  std::vector<uint64_t> armband;
+  unsigned int gyros = 0;
+  for(size_t n = 0; n < events.size(); n++) {
+    if(events[n].type == EVENT_ORIENTATION &&
+        (armband.empty() || events[n].timestamp != armband.back()))
+      armband.push_back(events[n].timestamp);
+    if(events[n].type == EVENT_GYROSCOPE)
+      gyros++;
+  }
+
+  if(gyros == 0 || armband.size() < 2) {
+    printf("No gyroscope samples, replay a session recorded with the armband or use --imu-rate\n");
+    return -1;
+  }
+
+  double seconds = (armband.back() - armband.front()) / 1000000.0;
+  printf("%u orientation and %u gyroscope samples over %.1f s\n",
+      (unsigned int) armband.size(), gyros, seconds);
+  printf("%8s %5s %5s %11s %11s %9s %10s %8s\n", "source", "kp", "ki", "rms err deg",
+      "max err deg", "updates/s", "stale ms", "ns/event");
+  printf("%8s %5s %5s %11s %11s %9.1f %10.2f %8s\n", "armband", "-", "-", "-", "-",
+      armband.size() / seconds, staleness(armband), "-");
+
+  const float kps[] = {1, 5, 20};
+  const float kis[] = {0, 0.1f};
+
+  for(int p = 0; p < 3; p++) {
+    for(int i = 0; i < 2; i++) {
+      Fusion fusion;
+      fusion.enabled = true;
+      fusion.kp = kps[p];
+      fusion.ki = kis[i];
+
+      //the estimate for each moment once every event stamped then is in
+      std::vector<InputEvent> fused;
+      for(size_t n = 0; n < events.size(); n++) {
+        InputEvent e = events[n];
+        fusion.apply(e);
+        if(e.type != EVENT_ORIENTATION)
+          continue;
+
+        if(!fused.empty() && fused.back().timestamp == e.timestamp)
+          fused.back() = e;
+        else
+          fused.push_back(e);
+      }
+
+      std::vector<uint64_t> updates;
+      for(size_t n = 0; n < fused.size(); n++)
+        updates.push_back(fused[n].timestamp);
+
+      //distance from the armband's orientation at the same moments, skipping
+      //the first second while the estimate settles
+      double sum = 0;
+      double worst = 0;
+      unsigned int compared = 0;
+      size_t j = 0;
+
+      for(size_t n = 0; n < events.size(); n++) {
+        const InputEvent & a = events[n];
+        if(a.type != EVENT_ORIENTATION || a.timestamp < armband.front() + 1000000)
+          continue;
+
+        while(j < fused.size() && fused[j].timestamp < a.timestamp)
+          j++;
+        if(j == fused.size())
+          break;
+        if(fused[j].timestamp != a.timestamp)
+          continue;
+
+        const float * q = fused[j].quat;
+        double dot = std::fabs(a.quat[0] * q[0] + a.quat[1] * q[1] + a.quat[2] * q[2] + a.quat[3] * q[3]);
+        double deg = 2 * std::acos(std::min(1.0, dot)) * 180 / M_PI;
+        sum += deg * deg;
+        worst = std::max(worst, deg);
+        compared++;
+      }
+
+      //cost on its own, without the bookkeeping above
+      Fusion timed;
+      timed.enabled = true;
+      timed.kp = kps[p];
+      timed.ki = kis[i];
+
+      std::vector<InputEvent> copy = events;
+      Clock::time_point begin = Clock::now();
+      for(size_t n = 0; n < copy.size(); n++)
+        timed.apply(copy[n]);
+      double cost = nsPer(begin, copy.size());
+
+      printf("%8s %5.1f %5.2f %11.3f %11.3f %9.1f %10.2f %8.1f\n", "fused", kps[p], kis[i],
+          compared ? std::sqrt(sum / compared) : 0.0, worst, updates.size() / seconds,
+          staleness(updates), cost);
+    }
+  }
+
+  return 0;
+}
+
+//seconds at each end of the session whose mean cursor is compared, a whole
+//number of periods of the circle and pauses patterns
+const double DRIFT_SPAN = 56;
+
+int benchDrift(const Options & opts) {
+  Options session = opts;
+  if(session.synthetic.duration <= 0)
+    session.synthetic.duration = 600;
+
+  std::vector<InputEvent> events;
+  replay(session, events);
+
+  std::vector<InputEvent> samples;
+  for(size_t n = 0; n < events.size(); n++)
+    if(events[n].type == EVENT_ORIENTATION)
+      samples.push_back(events[n]);
+
+  if(samples.size() < 2) {
+    printf("No orientation samples to replay\n");
+    return -1;
+  }
+
+  double seconds = (samples.back().timestamp - samples.front().timestamp) / 1000000.0;
+  if(seconds < 2 * DRIFT_SPAN) {
+    printf("Session is %.1f s, at least %.0f s are needed\n", seconds, 2 * DRIFT_SPAN);
+    return -1;
+  }
+
+  printf("%u orientation samples over %.1f s\n", (unsigned int) samples.size(), seconds);
+  printf("%10s %13s %7s %15s %15s %9s\n", "center", "drift deg/s", "stills",
+      "first mean px", "last mean px", "wander px");
+
+  for(int corrected = 0; corrected < 2; corrected++) {
+    DriftEstimator drift;
+    Pointer pointer(BENCH_WIDTH, BENCH_HEIGHT, 5, 3);
+    pointer.recenter(samples.front().quat);
+
+    PointerBatch batch;
+    batch.resize(1);
+
+    uint64_t start = samples.front().timestamp;
+    uint64_t end = samples.back().timestamp;
+    uint64_t span = (uint64_t) (DRIFT_SPAN * 1000000);
+    double first = 0, last = 0;
+    unsigned int firsts = 0, lasts = 0;
+
+    for(size_t n = 0; n < samples.size(); n++) {
+      const InputEvent & e = samples[n];
+      if(corrected) {
+        drift.add(e.timestamp, e.quat);
+        pointer.drift(drift.offset());
+      }
+
+      batch.w[0] = e.quat[0];
+      batch.x[0] = e.quat[1];
+      batch.y[0] = e.quat[2];
+      batch.z[0] = e.quat[3];
+      pointer.map(batch, 0, 1);
+
+      if(e.timestamp < start + span) {
+        first += batch.px[0];
+        firsts++;
+      }
+      if(e.timestamp > end - span) {
+        last += batch.px[0];
+        lasts++;
+      }
+    }
+
+    first /= firsts;
+    last /= lasts;
+
+    if(corrected)
+      printf("%10s %13.4f %7u %15.1f %15.1f %9.1f\n", "corrected", drift.rate() * 180 / M_PI,
+          drift.stills, first, last, last - first);
+    else
+      printf("%10s %13s %7s %15.1f %15.1f %9.1f\n", "raw", "-", "-", first, last, last - first);
+  }
+
+  //cost on its own, what the input path pays per sample
+  DriftEstimator timed;
+  Clock::time_point begin = Clock::now();
+  for(size_t n = 0; n < samples.size(); n++) {
+    timed.add(samples[n].timestamp, samples[n].quat);
+    sink = timed.offset();
+  }
+  printf("%.1f ns/sample\n", nsPer(begin, samples.size()));
+
+  return 0;
+}
+
+//how far apart the armband's pose and ours may be and still count as the same
+const uint64_t GESTURE_MATCH_US = 500000;
+
+const char * POSE_NAMES[POSE_TYPES] = {"fist", "tap", "spread", "rest"};
+
+int benchEmg(const Options & opts) {
+  std::vector<InputEvent> events;
+  replay(opts, events);
+
+  //every EMG sample, labelled with the armband's pose at the time
+  std::vector<InputEvent> samples;
+  std::vector<int> labels;
+  int pose = POSE_OTHER;
+  for(size_t n = 0; n < events.size(); n++) {
+    if(events[n].type == EVENT_POSE)
+      pose = events[n].value;
+    if(events[n].type == EVENT_EMG) {
+      samples.push_back(events[n]);
+      labels.push_back(pose);
+    }
+  }
+
+  if(samples.size() < 4 * EMG_WINDOW) {
+    printf("No EMG samples, replay a session recorded with the armband or use --emg-rate\n");
+    return -1;
+  }
+
+  const int rounds = std::max(1, (int) (2000000 / samples.size()));
+  printf("%u EMG samples over %.1f s\n", (unsigned int) samples.size(),
+      (samples.back().timestamp - samples.front().timestamp) / 1000000.0);
+
+  //both kernels have to keep exactly the same sums
+  EmgWindow scalar, simd;
+  scalar.simd = false;
+  unsigned int mismatched = 0;
+  for(size_t n = 0; n < samples.size(); n++) {
+    float a[EMG_FEATURES], b[EMG_FEATURES];
+    scalar.add(samples[n].emg);
+    simd.add(samples[n].emg);
+    scalar.features(a);
+    simd.features(b);
+    for(int f = 0; f < EMG_FEATURES; f++)
+      if(a[f] != b[f])
+        mismatched++;
+  }
+
+  double cost[2];
+  for(int k = 0; k < 2; k++) {
+    EmgWindow window;
+    window.simd = k == 1;
+    Clock::time_point begin = Clock::now();
+    for(int r = 0; r < rounds; r++)
+      for(size_t n = 0; n < samples.size(); n++)
+        window.add(samples[n].emg);
+    cost[k] = nsPer(begin, samples.size() * rounds);
+    float f[EMG_FEATURES];
+    window.features(f);
+    sink = f[0];
+  }
+
+  printf("%16s %14s %8s %11s\n", "scalar ns/smp", "simd ns/smp", "speedup", "mismatches");
+  printf("%16.2f %14.2f %7.2fx %11u\n", cost[0], cost[1], cost[0] / cost[1], mismatched);
+#ifndef __SSE2__
+  printf("built without SSE2, both columns are the scalar kernel\n");
+#endif
+
+  //train on the first half, labelled by the armband
+  size_t half = samples.size() / 2;
+  GestureClassifier classifier;
+  EmgWindow window;
+  float features[EMG_FEATURES];
+  for(size_t n = 0; n < half; n++) {
+    window.add(samples[n].emg);
+    if(!window.full())
+      continue;
+    window.features(features);
+    classifier.learn(features, labels[n]);
+  }
+
+  if(!classifier.train()) {
+    printf("The first half doesn't hold every pose, nothing to train on\n");
+    return -1;
+  }
+
+  //then run the second half through the input thread's stage, the armband's
+  //poses are what it is judged against
+  Gestures gestures;
+  gestures.classifier = classifier;
+  gestures.enabled = true;
+
+  uint64_t split = samples[half].timestamp;
+  std::vector<InputEvent> theirs, ours;
+  unsigned int agree = 0, compared = 0;
+  int current = -1;
+  int label = POSE_OTHER;
+
+  Clock::time_point begin = Clock::now();
+  unsigned int classified = 0;
+  for(size_t n = 0; n < events.size(); n++) {
+    InputEvent e = events[n];
+    if(e.timestamp < split)
+      continue;
+
+    if(e.type == EVENT_POSE) {
+      if(theirs.empty() || theirs.back().value != e.value)
+        theirs.push_back(e);
+      label = e.value;
+    }
+
+    bool emg = e.type == EVENT_EMG;
+    if(emg)
+      classified++;
+    InputEvent pose;
+    bool posed;
+    if(gestures.apply(e, pose, posed) && posed) {
+      ours.push_back(pose);
+      current = pose.value;
+    }
+
+    if(emg && current >= 0) {
+      agree += current == label;
+      compared++;
+    }
+  }
+  double classify = nsPer(begin, classified);
+
+  //each of the armband's pose changes, and when we saw the same one
+  double lead = 0;
+  unsigned int matched = 0;
+  std::vector<bool> used(ours.size(), false);
+  for(size_t n = 0; n < theirs.size(); n++) {
+    for(size_t m = 0; m < ours.size(); m++) {
+      if(used[m] || ours[m].value != theirs[n].value)
+        continue;
+      if(ours[m].timestamp + GESTURE_MATCH_US < theirs[n].timestamp)
+        continue;
+      if(ours[m].timestamp > theirs[n].timestamp + GESTURE_MATCH_US)
+        break;
+
+      used[m] = true;
+      lead += ((double) theirs[n].timestamp - (double) ours[m].timestamp) / 1000.0;
+      matched++;
+      break;
+    }
+  }
+
+  printf("%10s %8s %8s %9s %12s %12s\n", "armband", "ours", "matched", "spurious",
+      "lead ms", "agreement");
+  printf("%10u %8u %8u %9u %12.1f %11.1f%%\n", (unsigned int) theirs.size(),
+      (unsigned int) ours.size(), matched, (unsigned int) ours.size() - matched,
+      matched ? lead / matched : 0.0, compared ? 100.0 * agree / compared : 0.0);
+  printf("%.1f ns/sample for the whole stage\n", classify);
+
+  //confusion of our pose against the armband's, per EMG sample
+  printf("%8s", "");
+  for(int p = 0; p < POSE_TYPES; p++)
+    printf(" %7s", POSE_NAMES[p]);
+  printf("\n");
+
+  unsigned int confusion[POSE_TYPES][POSE_TYPES] = {{0}};
+  for(size_t n = half; n < samples.size(); n++) {
+    window.add(samples[n].emg);
+    window.features(features);
+    confusion[labels[n]][classifier.classify(features)]++;
+  }
+  for(int p = 0; p < POSE_TYPES; p++) {
+    printf("%8s", POSE_NAMES[p]);
+    for(int q = 0; q < POSE_TYPES; q++)
+      printf(" %7u", confusion[p][q]);
+    printf("\n");
+  }
+
+  if(!classifier.save(opts.gestureModel)) {
+    printf("Unable to write %s\n", opts.gestureModel.c_str());
+    return -1;
+  }
+  printf("Saved the classifier to %s\n", opts.gestureModel.c_str());
+  return 0;
+}
+
+int benchLog() {
+  //a burst fits the calling thread's buffer, the flusher empties it between
+  const int burst = 200;
+  const int bursts = 100;
+  const char * names[3] = {"filtered", "queued", "direct"};
+
+  FILE * sinkFile = tmpfile();
+  if(sinkFile == NULL) {
+    printf("Unable to open a temporary file\n");
+    return -1;
+  }
+
+  logger.redirect(sinkFile);
+  if(logger.start()) {
+    fclose(sinkFile);
+    return -1;
+  }
+
+  int level = logger.level;
+
+  //each thread's first message registers its buffer, once
+  logger.level = LOG_DEBUG;
+  logger.write(LOG_INFO, "Log bench");
+
+  printf("%8s %10s %10s\n", "call", "ns/call", "max ns");
+  for(int v = 0; v < 3; v++) {
+    logger.level = v == 0 ? LOG_ERROR : LOG_DEBUG;
+
+    //odd bursts time every call for the slowest, which costs more than a
+    //filtered call, even ones only the whole burst
+    double total = 0, slowest = 0;
+    for(int b = 0; b < bursts; b++) {
+      bool timed = b & 1;
+      Clock::time_point begin = Clock::now();
+
+      for(int n = 0; n < burst; n++) {
+        Clock::time_point call;
+        if(timed)
+          call = Clock::now();
+
+        //what the frame loop and the armband's callbacks did before
+        if(v == 2) {
+          fprintf(sinkFile, "FPS: %g\n", (double) n);
+          fflush(sinkFile);
+        }
+        else {
+          logger.write(LOG_INFO, "FPS: %g", n);
+        }
+
+        if(timed)
+          slowest = std::max(slowest, nsPer(call, 1));
+      }
+      if(!timed)
+        total += nsPer(begin, burst);
+
+      if(v == 1)
+        SDL_Delay(30);
+    }
+
+    printf("%8s %10.1f %10.1f\n", names[v], total / (bursts / 2), slowest);
+  }
+
+  //reports anything dropped
+  logger.stop();
+  logger.redirect(NULL);
+  logger.level = level;
+  fclose(sinkFile);
+  return 0;
+}
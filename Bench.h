@@ -0,0 +1,42 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Bench.h
+ Description:   Offline benchmarks, run from the command line instead of the
+                drawing loop.
+ *****************************************************************************/
+
+
+#ifndef BENCH_H
+#define BENCH_H
+
+struct Options;
+
+//stroke rasterizer vs the old per pixel SDL_FillRect stepping loop
+int benchStroke();
+
+//quaternion pointer vs the old Euler angle mapping
+int benchPointer();
+
+//jitter vs added latency of each filter setting, replaying the input
+//picked by --source and --file
+int benchFilter(const Options & opts);
+
+//how closely, how often and how cheaply the fused gyroscope tracks the
+//armband's orientation, on the same input
+int benchFusion(const Options & opts);
+
+//yaw drift learned while still and how far the cursor's center wanders
+//over the session with and without correcting it
+int benchDrift(const Options & opts);
+
+//scalar vs SSE2 EMG features, then how much earlier than the armband the
+//classifier trained on half the session picks up poses in the other half
+int benchEmg(const Options & opts);
+
+//a log call that is filtered out or queued for the flusher vs writing the
+//line out on the spot
+int benchLog();
+
+#endif /* BENCH_H */
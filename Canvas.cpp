@@ -0,0 +1,340 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Canvas.cpp
+ Description:   The drawing, an unbounded sparse grid of tiles allocated the
+                first time they're painted and seen through a movable view.
+                Each tile remembers which clear it was last painted after,
+                so clearing is a counter bump. Backed by a file, only a
+                budget of recently used tiles stays in memory.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "Canvas.h"
+
+#include <cstdio>
+#include <algorithm>
+
+//swept tiles kept around for the next strokes, the rest are freed
+const size_t CANVAS_SPARE_TILES = 64;
+
+//a file backed canvas keeps at least this many views' worth of tiles, so
+//panning back and forth doesn't go to the file every frame
+const int CANVAS_MIN_VIEWS = 4;
+
+int Canvas::tileOf(int v) {
+  return v >= 0 ? v / TILE_SIZE : -((-v + TILE_SIZE - 1) / TILE_SIZE);
+}
+
+static int recentSlot(int tx, int ty) {
+  return ((ty & 7) << 3) | (tx & 7);
+}
+
+Canvas::Canvas()
+: format(NULL), viewW(0), viewH(0), viewLeft(0), viewTop(0), newest(NULL), oldest(NULL),
+  budget(0), epoch(1), cleared(false), touched(false), versions(0), background(0) {
+  std::fill(recent, recent + 64, (Tile *) NULL);
+  SDL_Rect r = {-CANVAS_LIMIT, -CANVAS_LIMIT, 2 * CANVAS_LIMIT, 2 * CANVAS_LIMIT};
+  bounds = r;
+}
+
+Canvas::~Canvas() {
+  free();
+}
+
+int Canvas::init(int width, int height, Uint32 pixelFormat) {
+  free();
+
+  format = SDL_AllocFormat(pixelFormat);
+  if(format == NULL) {
+    printf("Canvas format could not be created! SDL Error: %s\n", SDL_GetError());
+    return -1;
+  }
+
+  viewW = width;
+  viewH = height;
+  viewLeft = 0;
+  viewTop = 0;
+
+  SDL_Rect r = {-CANVAS_LIMIT, -CANVAS_LIMIT, 2 * CANVAS_LIMIT, 2 * CANVAS_LIMIT};
+  bounds = r;
+  budget = 0;
+
+  epoch = 1;
+  cleared = false;
+  touched = true;
+
+  background = SDL_MapRGB(format, 0x00, 0x00, 0x00);
+
+  return 0;
+}
+
+int Canvas::open(const std::string & path, int side, size_t bytes) {
+  if(!store.open(path, side, TILE_SIZE, format->format))
+    return -1;
+
+  //whatever was painted before is dropped, the file's drawing takes over
+  epoch = store.epoch();
+  cleared = true;
+  bounds = store.extent();
+  pan(viewLeft, viewTop);
+
+  int cells = (viewW / TILE_SIZE + 2) * (viewH / TILE_SIZE + 2);
+  budget = std::max(bytes / sizeof(Tile), (size_t) (cells * CANVAS_MIN_VIEWS));
+
+  return 0;
+}
+
+void Canvas::free() {
+  //the file gets everything painted since it was last written
+  if(store.isOpen()) {
+    for(Tile * t = newest; t != NULL; t = t->older)
+      if(t->modified && t->gen == epoch)
+        store.save(t->tx, t->ty, t->gen, t->pixels);
+    store.close();
+  }
+
+  for(std::unordered_map<uint64_t, Tile *>::iterator it = grid.begin(); it != grid.end(); ++it)
+    delete it->second;
+  for(size_t n = 0; n < spare.size(); n++)
+    delete spare[n];
+
+  grid.clear();
+  spare.clear();
+  std::fill(recent, recent + 64, (Tile *) NULL);
+  newest = NULL;
+  oldest = NULL;
+
+  SDL_FreeFormat(format);
+  format = NULL;
+}
+
+void Canvas::clear() {
+  epoch++;
+  cleared = true;
+  touched = true;
+
+  if(store.isOpen())
+    store.setEpoch(epoch);
+}
+
+void Canvas::pan(int x, int y) {
+  x = std::max(bounds.x, std::min(x, bounds.x + bounds.w - viewW));
+  y = std::max(bounds.y, std::min(y, bounds.y + bounds.h - viewH));
+
+  if(x == viewLeft && y == viewTop)
+    return;
+
+  viewLeft = x;
+  viewTop = y;
+  touched = true;
+}
+
+Uint32 Canvas::mapRGB(Uint8 r, Uint8 g, Uint8 b) {
+  return SDL_MapRGB(format, r, g, b);
+}
+
+uint64_t Canvas::key(int tx, int ty) {
+  return ((uint64_t) (Uint32) ty << 32) | (Uint32) tx;
+}
+
+void Canvas::unlink(Tile * t) {
+  (t->newer != NULL ? t->newer->older : newest) = t->older;
+  (t->older != NULL ? t->older->newer : oldest) = t->newer;
+}
+
+//most recently used goes first
+void Canvas::touch(Tile * t) {
+  if(t == newest)
+    return;
+
+  unlink(t);
+  t->newer = NULL;
+  t->older = newest;
+  newest->newer = t;
+  newest = t;
+}
+
+//tile tx, ty if it's in memory, or in the file and painted since the last clear
+Canvas::Tile * Canvas::find(int tx, int ty) {
+  Tile *& slot = recent[recentSlot(tx, ty)];
+  if(slot != NULL && slot->tx == tx && slot->ty == ty) {
+    touch(slot);
+    return slot;
+  }
+
+  std::unordered_map<uint64_t, Tile *>::iterator it = grid.find(key(tx, ty));
+  if(it != grid.end()) {
+    slot = it->second;
+    touch(slot);
+    return slot;
+  }
+
+  if(!store.isOpen() || !store.has(tx, ty, epoch))
+    return NULL;
+
+  Tile * t = allocate(tx, ty);
+  store.load(tx, ty, epoch, t->pixels);
+  t->gen = epoch;
+  t->version = ++versions;
+  return t;
+}
+
+//room for tile tx, ty, put in the grid as the most recently used
+Canvas::Tile * Canvas::allocate(int tx, int ty) {
+  Tile * t = NULL;
+
+  if(budget > 0 && grid.size() >= budget)
+    t = evict();
+  if(t == NULL && !spare.empty()) {
+    t = spare.back();
+    spare.pop_back();
+  }
+  if(t == NULL)
+    t = new Tile;
+
+  t->tx = tx;
+  t->ty = ty;
+  t->gen = 0;
+  t->modified = false;
+  grid[key(tx, ty)] = t;
+  recent[recentSlot(tx, ty)] = t;
+
+  t->newer = NULL;
+  t->older = newest;
+  (newest != NULL ? newest->newer : oldest) = t;
+  newest = t;
+
+  return t;
+}
+
+//least recently used tile, written to the file first if it was painted
+Canvas::Tile * Canvas::evict() {
+  Tile * t = oldest;
+  if(t == NULL)
+    return NULL;
+
+  if(t->modified && t->gen == epoch)
+    store.save(t->tx, t->ty, t->gen, t->pixels);
+
+  unlink(t);
+  grid.erase(key(t->tx, t->ty));
+  Tile *& slot = recent[recentSlot(t->tx, t->ty)];
+  if(slot == t)
+    slot = NULL;
+
+  return t;
+}
+
+//the tile about to be written, allocated the first time it's painted and
+//given its background back the first time it's painted after a clear
+Canvas::Tile & Canvas::paint(int tx, int ty) {
+  Tile * t = find(tx, ty);
+
+  if(t == NULL)
+    t = allocate(tx, ty);
+
+  if(t->gen != epoch) {
+    std::fill(t->pixels, t->pixels + TILE_SIZE * TILE_SIZE, background);
+    t->gen = epoch;
+  }
+
+  t->modified = true;
+  t->version = ++versions;
+  touched = true;
+  return *t;
+}
+
+//every 8 bit channel at once, two at a time in each half of a 32 bit word
+static void blend(Uint32 * pixels, int count, Uint32 color, Uint8 alpha) {
+  Uint32 a = alpha + (alpha >> 7);
+  Uint32 srcLow = (color & 0x00FF00FF) * a;
+  Uint32 srcHigh = ((color >> 8) & 0x00FF00FF) * a;
+
+  for(int n = 0; n < count; n++) {
+    Uint32 d = pixels[n];
+    Uint32 low = ((srcLow + (d & 0x00FF00FF) * (256 - a)) >> 8) & 0x00FF00FF;
+    Uint32 high = (srcHigh + ((d >> 8) & 0x00FF00FF) * (256 - a)) & 0xFF00FF00;
+    pixels[n] = low | high;
+  }
+}
+
+void Canvas::fillSpan(int y, int x0, int x1, Uint32 color, Uint8 alpha) {
+  if(y < bounds.y || y >= bounds.y + bounds.h)
+    return;
+
+  x0 = std::max(x0, bounds.x);
+  x1 = std::min(x1, bounds.x + bounds.w - 1);
+  if(x1 < x0)
+    return;
+
+  int ty = tileOf(y);
+  int row = y - ty * TILE_SIZE;
+
+  //one tile at a time so each is allocated or revived before it's written
+  for(int x = x0; x <= x1; ) {
+    int tx = tileOf(x);
+    int left = x - tx * TILE_SIZE;
+    int right = std::min(x1 - tx * TILE_SIZE, TILE_SIZE - 1);
+    Tile & t = paint(tx, ty);
+    Uint32 * line = t.pixels + row * TILE_SIZE;
+
+    if(alpha == 255)
+      std::fill(line + left, line + right + 1, color);
+    else
+      blend(line + left, right - left + 1, color, alpha);
+
+    x = tx * TILE_SIZE + right + 1;
+  }
+}
+
+Uint32 Canvas::getPixel(int x, int y) {
+  int tx = tileOf(x), ty = tileOf(y);
+  Tile * t = find(tx, ty);
+
+  if(t == NULL || t->gen != epoch)
+    return background;
+  return t->pixels[(y - ty * TILE_SIZE) * TILE_SIZE + x - tx * TILE_SIZE];
+}
+
+const Uint32 * Canvas::tile(int tx, int ty, Uint64 & version) {
+  Tile * t = find(tx, ty);
+  if(t == NULL || t->gen != epoch)
+    return NULL;
+
+  version = t->version;
+  return t->pixels;
+}
+
+//give back tiles painted before the last clear, they read as background
+//and nothing shows them any more
+void Canvas::sweep() {
+  std::unordered_map<uint64_t, Tile *>::iterator it = grid.begin();
+  while(it != grid.end()) {
+    Tile * t = it->second;
+    if(t->gen == epoch) {
+      ++it;
+      continue;
+    }
+
+    unlink(t);
+    if(spare.size() < CANVAS_SPARE_TILES)
+      spare.push_back(t);
+    else
+      delete t;
+    it = grid.erase(it);
+  }
+
+  std::fill(recent, recent + 64, (Tile *) NULL);
+}
+
+void Canvas::drawn() {
+  touched = false;
+
+  //nothing on screen needs the stale tiles any more
+  if(cleared) {
+    cleared = false;
+    sweep();
+  }
+}
@@ -0,0 +1,131 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Canvas.h
+ Description:   The drawing, an unbounded sparse grid of tiles allocated the
+                first time they're painted and seen through a movable view.
+                Each tile remembers which clear it was last painted after,
+                so clearing is a counter bump. Backed by a file, only a
+                budget of recently used tiles stays in memory.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include "TileStore.h"
+
+#ifndef CANVAS_H
+#define CANVAS_H
+
+const int TILE_SIZE = 64;
+
+//world coordinates run this far from the origin each way, floats still
+//place stroke points to an eighth of a pixel out there
+const int CANVAS_LIMIT = 1 << 20;
+
+class Canvas{
+  public:
+    Canvas();
+    ~Canvas();
+
+    //the view onto the canvas is width x height
+    int init(int width, int height, Uint32 format);
+    void free();
+
+    //after init, keep the drawing in path, side x side pixels around the
+    //origin when it's new. At most budget bytes of tiles stay in memory, the
+    //least recently used are written back to the file to make room
+    int open(const std::string & path, int side, size_t budget);
+
+    //O(1), tiles painted before this read as background from now on and
+    //are given back once the view has been drawn
+    void clear();
+
+    //paint world pixels x0..x1 of row y, blended over what is there below
+    //alpha 255
+    void fillSpan(int y, int x0, int x1, Uint32 color, Uint8 alpha = 255);
+
+    //put the view's top left corner at world x, y
+    void pan(int x, int y);
+
+    //pixels of tile tx, ty and a version that changes whenever they do,
+    //NULL for background. From a file the tile is read back in if needed
+    const Uint32 * tile(int tx, int ty, Uint64 & version);
+
+    //tile tx, ty holding world coordinate v, rounding down for negatives too
+    static int tileOf(int v);
+
+    //anything painted, cleared or panned since the view was last drawn
+    bool changed() { return touched; }
+
+    //the view as it is now is on screen
+    void drawn();
+
+    //world coordinates
+    Uint32 getPixel(int x, int y);
+    Uint32 mapRGB(Uint8 r, Uint8 g, Uint8 b);
+
+    //size of the view
+    int width() { return viewW; }
+    int height() { return viewH; }
+
+    int viewX() { return viewLeft; }
+    int viewY() { return viewTop; }
+
+    //every world pixel that can be painted
+    SDL_Rect extent() { return bounds; }
+
+    //tiles in memory, they grow with what's painted rather than the extent,
+    //and with a file stop at the budget
+    size_t tiles() { return grid.size(); }
+    size_t bytes() { return (grid.size() + spare.size()) * sizeof(Tile) + store.bytes(); }
+
+    TileStore store;
+
+  private:
+    struct Tile {
+      int tx, ty;         //world position in tiles
+      unsigned int gen;   //clear epoch the pixels belong to
+      Uint64 version;     //a new one each time the pixels change
+      bool modified;      //painted since it was last written to the file
+      Tile * newer;       //most recently used first
+      Tile * older;
+      Uint32 pixels[TILE_SIZE * TILE_SIZE];
+    };
+
+    static uint64_t key(int tx, int ty);
+    Tile * find(int tx, int ty);
+    Tile & paint(int tx, int ty);
+    Tile * allocate(int tx, int ty);
+    Tile * evict();
+    void touch(Tile * t);
+    void unlink(Tile * t);
+    void sweep();
+
+    SDL_PixelFormat * format;
+    int viewW, viewH;
+    int viewLeft, viewTop;
+    SDL_Rect bounds;
+
+    std::unordered_map<uint64_t, Tile *> grid;
+    std::vector<Tile *> spare;  //swept tiles kept for reuse
+    Tile * newest;
+    Tile * oldest;
+    size_t budget;              //tiles kept in memory, 0 for no limit
+
+    //recently painted tiles by the low bits of their position, most spans
+    //land in one of these
+    Tile * recent[64];
+
+    unsigned int epoch;
+    bool cleared;     //stale tiles to sweep once drawn
+    bool touched;
+    Uint64 versions;
+    Uint32 background;
+};
+
+#endif /* CANVAS_H */
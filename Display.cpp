@@ -12,6 +12,27 @@
 #include "SDL2/include/SDL2/SDL.h"
 #include "SDL_image/include/SDL2/SDL_image.h"
 #include "Display.h"
+#include "Stroke.h"
+#include "Bench.h"
+#include "Input.h"
+#include "Options.h"
+#include "MyoSource.h"
+#include "SyntheticSource.h"
+#include "FileSource.h"
+#include "Profiler.h"
+#include "Tracer.h"
+#include "LatencyProbe.h"
+#include "Canvas.h"
+#include "TileTextures.h"
+#include "Predictor.h"
+#include "Pointer.h"
+#include "Filter.h"
+#include "Fusion.h"
+#include "Drift.h"
+#include "Gesture.h"
+#include "Pressure.h"
+#include "Log.h"
+#include "FrameScheduler.h"
 
 #include <iostream>
 #include <cstdio>
@@ -23,7 +44,8 @@
 #include <stdexcept>
 #include <string>
 #include <algorithm>
-#include <myo/myo.hpp>
+#include <vector>
+#include <memory>
 
 using std::cout;
 using std::endl;
@@ -31,21 +53,34 @@ using std::endl;
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
 
-const int POSE_FIST = 0;
-const int POSE_TAP = 1;
-const int POSE_SPREAD = 2;
-const int POSE_OTHER = 3;
-
 const int X_SENS = 5;
 const int Y_SENS = 3;
 
+//--pressure emg, stroke radius and alpha from no grip to full grip
+const float PRESSURE_RADIUS[2] = {1, 8};
+const int PRESSURE_ALPHA[2] = {40, 255};
+
+//--pan edge, the view scrolls while the cursor is within PAN_EDGE of an
+//edge of the window, faster the deeper it pushes
+const float PAN_EDGE = 40;
+const float PAN_SPEED = 600;        //pixels per second pushed to the edge or past it
+const float PAN_MAX_STEP = 0.05f;   //seconds, the longest step after a pause
+
+//tile textures kept, in views' worth of tiles
+const int TILE_TEXTURE_VIEWS = 2;
+
+//longest an idle loop sleeps, so the FPS line, profile exports and trace
+//flushes still come out
+const Uint32 IDLE_WAIT_MS = 100;
+
 SDL_Window * window = NULL; //window to render to
 SDL_Surface * screenSurface = NULL; //surface contained by window
-SDL_Surface * drawSurface = NULL;
+Canvas canvas; //the drawing, painted tiles in view are uploaded to drawTiles as they change
 
 SDL_Renderer * renderer = NULL;
 SDL_Texture * mouseTexture;
-SDL_Texture * drawTexture;
+TileTextures drawTiles;
+Uint32 drawFormat = SDL_PIXELFORMAT_ARGB8888;
 SDL_Event event;
 SDL_Rect mouseRect;
 SDL_Rect tile;
@@ -53,7 +88,60 @@ SDL_Rect downRect;
 SDL_Rect upRect;
 SDL_Rect pointerRect;
 
-int lastX, lastY;
+//predicted stroke tip drawn over the canvas for one frame
+std::vector<SDL_Rect> tipRects;
+SDL_Color tipColor;
+
+//what the last presented frame showed, a frame that would look the same
+//isn't drawn
+bool shown = true;        //window not minimized or hidden
+bool exposed = true;      //window contents need drawing again
+SDL_Rect shownMouse;
+SDL_Rect shownPointer;
+std::vector<SDL_Rect> shownTips;
+
+//canvas coordinates, the screen plus where the view is
+float lastX, lastY;
+float lastRadius = 0;
+Uint8 lastAlpha = 255;
+
+//the stroke's last drawn segment runs from tail to lastX, lastY. Blended
+//strokes start the next frame's polyline on it so it isn't painted twice
+StrokePoint tail;
+bool hasTail = false;
+bool pressureWidth = false; //--pressure emg
+
+bool edgePan = false; //--pan edge
+float panX = 0, panY = 0; //view position, fractions kept between frames
+Uint64 panStep = 0; //when the view last moved
+
+//armband state after one input event and where it lands on screen
+struct Sample {
+  uint64_t timestamp;
+  Uint64 drained;
+  int pose;
+  float quat[4];
+  unsigned int centered;
+  float pressure;
+  float x, y, radius;
+  Uint8 alpha;
+};
+
+std::vector<Sample> samples; //everything drained this frame, in order
+size_t mapped = 0; //samples already on screen, latched ones stay mapped
+Sample latest; //the newest mapped sample
+
+Pointer pointer(SCREEN_WIDTH, SCREEN_HEIGHT, X_SENS, Y_SENS);
+PointerBatch batch;
+unsigned int centered = 0; //InputState::centered the pointer is on
+DriftEstimator drift;
+bool driftCorrect = true;
+Predictor predictor;
+OrientationFilter filter; //runs on the input thread, tuned from the keyboard
+Fusion fusion;
+Gestures gestures;
+Pressure grip;
+std::vector<StrokePoint> path; //fist samples not yet drawn
 
 bool mouseDown = false;
 bool calibrate = false;
@@ -63,165 +151,59 @@ bool yInvert = false;
 
 bool firstFist = false;
 
-// Classes that inherit from myo::DeviceListener can be used to receive events from Myo devices. DeviceListener
-// provides several virtual functions for handling different kinds of events. If you do not override an event, the
-// default behavior is to do nothing.
-class DataCollector : public myo::DeviceListener {
-  public:
-    DataCollector()
-    : onArm(false), isUnlocked(false), roll_w(0), pitch_w(0), yaw_w(0), currentPose() {}
+//headless runs render into frameSurface instead of a window
+bool headless = false;
+SDL_Surface * frameSurface = NULL;
 
-    void onPair(myo::Myo * myo, uint64_t timestamp) {
-      printf("Myo Paired");
-    }
-
-    // onUnpair() is called whenever the Myo is disconnected from Myo Connect by the user.
-    void onUnpair(myo::Myo* myo, uint64_t timestamp) {
-      // We've lost a Myo.
-      // Let's clean up some leftover state.
-      roll_w = 0;
-      pitch_w = 0;
-      yaw_w = 0;
-      onArm = false;
-      isUnlocked = false;
-    }
-    // onOrientationData() is called whenever the Myo device provides its current orientation, which is represented
-    // as a unit quaternion.
-    void onOrientationData(myo::Myo* myo, uint64_t timestamp, const myo::Quaternion<float>& quat) {
-      using std::atan2;
-      using std::asin;
-      using std::sqrt;
-      using std::max;
-      using std::min;
-      // Calculate Euler angles (roll, pitch, and yaw) from the unit quaternion.
-      float roll = atan2(2.0f * (quat.w() * quat.x() + quat.y() * quat.z()),
-                         1.0f - 2.0f * (quat.x() * quat.x() + quat.y() * quat.y()));
-      float pitch = asin(max(-1.0f, min(1.0f, 2.0f * (quat.w() * quat.y() - quat.z() * quat.x()))));
-      float yaw = atan2(2.0f * (quat.w() * quat.z() + quat.x() * quat.y()),
-                      1.0f - 2.0f * (quat.y() * quat.y() + quat.z() * quat.z()));
-      // Convert the floating point angles in radians to a scale from 0 to 1800.
-      roll_w = static_cast<int>((roll + (float)M_PI)/(M_PI * 2.0f) * 1800);
-      pitch_w = static_cast<int>((pitch + (float)M_PI/2.0f)/M_PI * 1800);
-      yaw_w = static_cast<int>((yaw + (float)M_PI)/(M_PI * 2.0f) * 1800);
-      //if(yaw_w < 0) yaw_w += 1800;
-    }
-    // onPose() is called whenever the Myo detects that the person wearing it has changed their pose, for example,
-    // making a fist, or not making a fist anymore.
-    void onPose(myo::Myo* myo, uint64_t timestamp, myo::Pose pose) {
+int Display::init(bool offscreen, bool vsync) {
 
-      if(pose == myo::Pose::fist) {
-        printf("\nFist pose\n");
+  headless = offscreen;
 
-      } else if(currentPose == myo::Pose::fist) {
-        printf("\nFist stop\n");
+  //no display needed, SDL's dummy driver never opens one
+  if(headless)
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
 
-      }
-      else if(pose == myo::Pose::doubleTap) {
-        zPitch = pitch_w - 900;
-        zYaw = yaw_w - 900;
-
-      }
-      else {
-      }
-      currentPose = pose;
-
-    }
-    // onArmSync() is called whenever Myo has recognized a Sync Gesture after someone has put it on their
-    // arm. This lets Myo know which arm it's on and which way it's facing.
-    void onArmSync(myo::Myo* myo, uint64_t timestamp, myo::Arm arm, myo::XDirection xDirection, float rotation,
-                   myo::WarmupState warmupState) {
-      printf("\nArm sync successful.\n");
-      onArm = true;
-      whichArm = arm;
-    }
-    // onArmUnsync() is called whenever Myo has detected that it was moved from a stable position on a person's arm after
-    // it recognized the arm. Typically this happens when someone takes Myo off of their arm, but it can also happen
-    // when Myo is moved around on the arm.
-    void onArmUnsync(myo::Myo* myo, uint64_t timestamp)
-    {
-      printf("\nArm unsynced.\n");
-      onArm = false;
-    }
-    // onUnlock() is called whenever Myo has become unlocked, and will start delivering pose events.
-    void onUnlock(myo::Myo* myo, uint64_t timestamp)
-    {
-      printf("\nUnlocked.\n");
-      isUnlocked = true;
-    }
-    // onLock() is called whenever Myo has become locked. No pose events will be sent until the Myo is unlocked again.
-    void onLock(myo::Myo* myo, uint64_t timestamp)
-    {
-      printf("\nLocked.\n");
-      isUnlocked = false;
-    }
-    // There are other virtual functions in DeviceListener that we could override here, like onAccelerometerData().
-    // For this example, the functions overridden above are sufficient.
-    // We define this function to print the current values that were updated by the on...() functions above.
-    void print()
-    {
-      cout << roll_w - zRoll << " " << pitch_w - zPitch << " " << yaw_w - zYaw << endl;
-    }
+  //attempt to init SDL
+  if(SDL_Init(SDL_INIT_VIDEO) < 0) {
+    printf("SDL init failed! SDL_Error: %s\n", SDL_GetError());
+    return -1;
+  }
 
-    int getPose() {
-      if(currentPose == myo::Pose::fist)
-        return POSE_FIST;
-      else if(currentPose == myo::Pose::doubleTap)
-        return POSE_TAP;
-      else if(currentPose == myo::Pose::fingersSpread)
-        return POSE_SPREAD;
-      else
-        return POSE_OTHER;
-    }
+  Uint32 windowFormat;
 
-    int getRoll() {
-      return roll_w - zRoll;
-    }
+  if(headless) {
+    frameSurface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 
+        32, SDL_PIXELFORMAT_ARGB8888);
 
-    int getPitch() {
-      return pitch_w - zPitch;
+    if(frameSurface == NULL) {
+      printf("Frame surface could not be created! SDL Error: %s\n", SDL_GetError());
+      return -1;
     }
 
-    int getYaw() {
-      return yaw_w - zYaw;
+    renderer = SDL_CreateSoftwareRenderer(frameSurface);
+    windowFormat = frameSurface->format->format;
+  }
+  else {
+    //attempt to create window  
+    window = SDL_CreateWindow("MyoDraw", 
+        SDL_WINDOWPOS_UNDEFINED, 
+        SDL_WINDOWPOS_UNDEFINED, 
+        SCREEN_WIDTH, 
+        SCREEN_HEIGHT, 
+        SDL_WINDOW_SHOWN);
+
+    if(window == NULL) {
+      printf("Window creation failed! SDL_Error: %s\n", SDL_GetError());
+      return -1;
     }
 
-    // These values are set by onArmSync() and onArmUnsync() above.
-    bool onArm;
-    myo::Arm whichArm;
-    // This is set by onUnlocked() and onLocked() above.
-    bool isUnlocked;
-    // These values are set by onOrientationData() and onPose() above.
-    int roll_w, pitch_w, yaw_w;
-
-    int zRoll = 0;
-    int zPitch = pitch_w - 900;
-    int zYaw = yaw_w - 900;
-    myo::Pose currentPose;
-};
-
-int Display::init() {
-
-  //attempt to init SDL
-  if(SDL_Init(SDL_INIT_VIDEO) < 0) {
-    printf("SDL init failed! SDL_Error: %s\n", SDL_GetError());
-    return -1;
-  }
- 
-  //attempt to create window  
-  window = SDL_CreateWindow("MyoDraw", 
-      SDL_WINDOWPOS_UNDEFINED, 
-      SDL_WINDOWPOS_UNDEFINED, 
-      SCREEN_WIDTH, 
-      SCREEN_HEIGHT, 
-      SDL_WINDOW_SHOWN);
-
-  if(window == NULL) {
-    printf("Window creation failed! SDL_Error: %s\n", SDL_GetError());
-    return -1;
+    Uint32 flags = SDL_RENDERER_ACCELERATED;
+    if(vsync)
+      flags |= SDL_RENDERER_PRESENTVSYNC;
+    renderer = SDL_CreateRenderer(window, -1, flags);
+    windowFormat = SDL_GetWindowPixelFormat(window);
   }
 
-  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-
   if(renderer == NULL) {
     printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
     return -1;
@@ -233,17 +215,42 @@ int Display::init() {
     printf("SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError());
   }
 
-  screenSurface = SDL_GetWindowSurface(window);
+  //pick a 32 bit format the renderer can stream without converting,
+  //preferring the window's own format
+  SDL_RendererInfo info;
+  bool found = false;
+
+  if(SDL_GetRendererInfo(renderer, &info) == 0) {
+    for(Uint32 f = 0; f < info.num_texture_formats; f++) {
+      Uint32 format = info.texture_formats[f];
+      if(SDL_ISPIXELFORMAT_FOURCC(format) || SDL_BYTESPERPIXEL(format) != 4)
+        continue;
+      if(format == windowFormat) {
+        drawFormat = format;
+        break;
+      }
+      if(!found)
+        drawFormat = format;
+      found = true;
+    }
+  }
 
-  //drawSurface = SDL_GetWindowSurface(window);
-  drawSurface = SDL_CreateRGBSurface(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, 0, 0, 0, 0);
+  if(canvas.init(SCREEN_WIDTH, SCREEN_HEIGHT, drawFormat))
+    return -1;
+
+  //a small texture per painted tile in view, with room for as many again
+  //so panning back doesn't upload them all over
+  int cells = (SCREEN_WIDTH / TILE_SIZE + 2) * (SCREEN_HEIGHT / TILE_SIZE + 2);
+  drawTiles.init(renderer, drawFormat, cells * TILE_TEXTURE_VIEWS);
+
+  if(headless)
+    return 0;
+
+  screenSurface = SDL_GetWindowSurface(window);
 
   SDL_FillRect(screenSurface, NULL, 
       SDL_MapRGB(screenSurface->format, 0x00, 0x00, 0x00));
   
-  SDL_FillRect(drawSurface, NULL, 
-      SDL_MapRGB(drawSurface->format, 0x00, 0x00, 0x00));
-  
   SDL_UpdateWindowSurface(window);
 
   SDL_ShowCursor(SDL_DISABLE);
@@ -251,6 +258,24 @@ int Display::init() {
   return 0;
 }
 
+void Display::status(const std::string & text) {
+  if(window == NULL)
+    return;
+  std::string title = "MyoDraw";
+  if(!text.empty())
+    title += " - " + text;
+  SDL_SetWindowTitle(window, title.c_str());
+}
+
+double Display::refreshRate() {
+  SDL_DisplayMode mode;
+  int display = window != NULL ? SDL_GetWindowDisplayIndex(window) : 0;
+
+  if(display < 0 || SDL_GetCurrentDisplayMode(display, &mode) != 0 || mode.refresh_rate <= 0)
+    return 60;
+  return mode.refresh_rate;
+}
+
 int Display::load() {
   mouseTexture = loadTexture("crosshair16.png");
   //TODO actually check whether texture was loaded, unloaded -> NULL
@@ -278,6 +303,12 @@ SDL_Texture * Display::loadTexture(std::string path) {
   return result;
 }
 
+//current tuning, after every key that changes it
+void printFilter() {
+  cout << "Filter " << FILTER_NAMES[filter.type] << " min cutoff " << filter.minCutoff
+      << " Hz beta " << filter.beta << endl;
+}
+
 int Display::handleEvents() {
   int x, y;
 
@@ -297,14 +328,37 @@ int Display::handleEvents() {
             if(yInvert) yInvert = false;
             else yInvert = true;
             break;
+
+          //filter tuning: f cycles the filter, [ ] min cutoff, - = beta
+          case SDLK_f:
+            filter.type = (filter.type + 1) % FILTER_TYPES;
+            printFilter();
+            break;
+          case SDLK_LEFTBRACKET:
+            filter.minCutoff = filter.minCutoff / 1.25f;
+            printFilter();
+            break;
+          case SDLK_RIGHTBRACKET:
+            filter.minCutoff = filter.minCutoff * 1.25f;
+            printFilter();
+            break;
+          case SDLK_MINUS:
+            filter.beta = filter.beta / 1.25f;
+            printFilter();
+            break;
+          case SDLK_EQUALS:
+            filter.beta = filter.beta * 1.25f;
+            printFilter();
+            break;
         }
         break;
       
       case SDL_MOUSEBUTTONDOWN:
         mouseDown = true;
         SDL_GetMouseState(&x, &y);
-        lastX = x;
-        lastY = y;
+        lastX = x + canvas.viewX();
+        lastY = y + canvas.viewY();
+        hasTail = false;
         firstFist = false;
         break;
       case SDL_MOUSEBUTTONUP:
@@ -321,193 +375,737 @@ int Display::handleEvents() {
 
         //cout << x << " " << y << endl;
         break;
+
+      //nothing is drawn while the window can't be seen
+      case SDL_WINDOWEVENT:
+        switch(event.window.event) {
+          case SDL_WINDOWEVENT_MINIMIZED:
+          case SDL_WINDOWEVENT_HIDDEN:
+            shown = false;
+            break;
+          case SDL_WINDOWEVENT_SHOWN:
+          case SDL_WINDOWEVENT_RESTORED:
+          case SDL_WINDOWEVENT_MAXIMIZED:
+            shown = true;
+            exposed = true;
+            break;
+          case SDL_WINDOWEVENT_EXPOSED:
+          case SDL_WINDOWEVENT_SIZE_CHANGED:
+            exposed = true;
+            break;
+        }
+        break;
     }
   }
   return 0;
 }
 
-void Display::render() {
+void Display::upload() {
+  int area = drawTiles.update(canvas);
+  tracer.counter("dirty_area", area);
+}
+
+//everything but the cursor, so input can be latched as late as possible
+void Display::compose() {
 
   //clear screen
   SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
   SDL_RenderClear(renderer);
 
   //copy the drawing to the screen
-  drawTexture = SDL_CreateTextureFromSurface(renderer, drawSurface);
-  SDL_RenderCopy(renderer, drawTexture, NULL, NULL);
-  SDL_DestroyTexture(drawTexture);
+  profiler.begin(STAGE_UPLOAD);
+  upload();
+  profiler.end(STAGE_UPLOAD);
+
+  profiler.begin(STAGE_COPY);
+  drawTiles.draw();
 
   //render crosshair
   SDL_RenderCopy(renderer, mouseTexture, NULL, &mouseRect);
+  profiler.end(STAGE_COPY);
+}
+
+void Display::present() {
+
+  //predicted stroke tip, gone again next frame
+  if(!tipRects.empty()) {
+    SDL_SetRenderDrawColor(renderer, tipColor.r, tipColor.g, tipColor.b, 0xFF);
+    SDL_RenderFillRects(renderer, &tipRects[0], tipRects.size());
+  }
 
   //render another crosshair
   SDL_RenderCopy(renderer, mouseTexture, NULL, &pointerRect);
 
   //show frame
+  profiler.begin(STAGE_PRESENT);
   SDL_RenderPresent(renderer);
+  profiler.end(STAGE_PRESENT);
   //SDL_UpdateWindowSurface(window);
+
+  exposed = false;
+  shownMouse = mouseRect;
+  shownPointer = pointerRect;
+  shownTips = tipRects;
+}
+
+bool Display::visible() {
+  return shown;
+}
+
+bool Display::stale() {
+  return exposed || canvas.changed();
+}
+
+bool Display::moved() {
+  if(!SDL_RectEquals(&mouseRect, &shownMouse) || !SDL_RectEquals(&pointerRect, &shownPointer))
+    return true;
+  if(tipRects.size() != shownTips.size())
+    return true;
+  for(size_t n = 0; n < tipRects.size(); n++)
+    if(!SDL_RectEquals(&tipRects[n], &shownTips[n]))
+      return true;
+  return false;
+}
+
+void Display::wait(Uint32 timeout) {
+  //NULL leaves the event queued for handleEvents()
+  SDL_WaitEventTimeout(NULL, timeout);
+}
+
+int Display::saveFrame(std::string path) {
+  SDL_Surface * frame = frameSurface;
+
+  //windows have to be read back from the renderer
+  if(!headless) {
+    frame = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 
+        32, SDL_PIXELFORMAT_ARGB8888);
+    if(frame == NULL || SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, 
+        frame->pixels, frame->pitch)) {
+      printf("Unable to read frame! SDL Error: %s\n", SDL_GetError());
+      SDL_FreeSurface(frame);
+      return -1;
+    }
+  }
+
+  int result = IMG_SavePNG(frame, path.c_str());
+  if(result)
+    printf("Unable to save %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+
+  if(!headless)
+    SDL_FreeSurface(frame);
+
+  return result;
+}
+
+Uint32 Display::checksum(const SDL_Rect & area) {
+  static std::vector<Uint32> pixels;
+  pixels.resize(area.w * area.h);
+
+  if(SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_ARGB8888, &pixels[0], area.w * 4))
+    return 0;
+
+  //FNV-1a
+  Uint32 hash = 2166136261u;
+  for(unsigned int n = 0; n < pixels.size(); n++)
+    hash = (hash ^ pixels[n]) * 16777619u;
+  return hash;
 }
 
 void Display::stop() {
+  drawTiles.free();
+  canvas.free();
   SDL_DestroyRenderer(renderer);
-  SDL_DestroyWindow(window);
+  if(window != NULL)
+    SDL_DestroyWindow(window);
+  SDL_FreeSurface(frameSurface);
   SDL_Quit();
 }
 
+//build the input source picked on the command line, the armband is looked
+//for once the source starts
+InputSource * openSource(Options & opts, LatencyProbe & probe) {
+  if(opts.probe > 0) {
+    std::cout << "Probing latency with " << opts.probe << " steps" << std::endl;
+    return new ProbeSource(probe, opts.probe);
+  }
+
+  if(opts.source == "synthetic") {
+    std::cout << "Using synthetic " << opts.synthetic.pattern << " input" << std::endl;
+    return new SyntheticSource(opts.synthetic);
+  }
+
+  if(opts.source == "file") {
+    FileSource * source = new FileSource(opts.file, opts.speed);
+    if(!source->open()) {
+      delete source;
+      throw std::runtime_error("Unable to open " + opts.file);
+    }
+    std::cout << "Playing back " << opts.file << std::endl;
+    return source;
+  }
+
+#ifdef NO_MYO
+  throw std::runtime_error("Built without the Myo SDK!");
+#else
+  MyoSource * source = new MyoSource("com.example.myoSign");
+  source->streamEmg(opts.poses == "emg" || opts.pressure == "emg" || !opts.record.empty());
+
+  // The Myo pairs in the background while the window comes up, see MyoSource::run().
+  std::cout << "Looking for a Myo..." << std::endl;
+  return source;
+#endif
+}
+
+//snapshot of the armband after an event, mapped later in the frame
+Sample sample(InputState & state) {
+  Sample s;
+  s.timestamp = state.timestamp;
+  s.drained = SDL_GetPerformanceCounter();
+  s.pose = state.getPose();
+  for(int n = 0; n < 4; n++)
+    s.quat[n] = state.quat[n];
+  s.centered = state.centered;
+  s.pressure = state.pressure;
+  return s;
+}
+
+//queue everything the source has sent since the last call onto samples
+void drain(InputSource & input, InputState & state, LatencyProbe * probe, unsigned int frame) {
+  InputEvent e;
+  while(input.poll(e)) {
+    state.apply(e);
+    if(probe)
+      probe->drained(e, frame);
+    if(e.type == EVENT_ORIENTATION || e.type == EVENT_POSE)
+      samples.push_back(sample(state));
+  }
+}
+
+//put every sample not yet mapped on the screen, a batch at a time between
+//recenters, and hand them to the predictor
+void mapSamples() {
+  size_t count = samples.size() - mapped;
+  if(count == 0)
+    return;
+
+  batch.resize(count);
+  for(size_t n = 0; n < count; n++) {
+    const Sample & s = samples[mapped + n];
+    batch.w[n] = s.quat[0];
+    batch.x[n] = s.quat[1];
+    batch.y[n] = s.quat[2];
+    batch.z[n] = s.quat[3];
+  }
+
+  pointer.invert(xInvert, yInvert);
+
+  //motion before the last recenter says nothing about motion after it
+  size_t restart = count;
+
+  size_t begin = 0;
+  while(begin < count) {
+    //the sample that recentered points at the new center
+    const Sample & first = samples[mapped + begin];
+    if(first.centered != centered) {
+      pointer.recenter(first.quat);
+      drift.recenter();
+      centered = first.centered;
+      restart = begin;
+    }
+
+    size_t end = begin + 1;
+    while(end < count && samples[mapped + end].centered == centered)
+      end++;
+
+    //slow yaw drift learned while the arm is still turns the center with it
+    if(driftCorrect) {
+      for(size_t n = begin; n < end; n++)
+        drift.add(samples[mapped + n].timestamp, samples[mapped + n].quat);
+      pointer.drift(drift.offset());
+    }
+
+    pointer.map(batch, begin, end);
+    begin = end;
+  }
+
+  for(size_t n = 0; n < count; n++) {
+    Sample & s = samples[mapped + n];
+    s.x = batch.px[n];
+    s.y = batch.py[n];
+    s.radius = batch.radius[n];
+    s.alpha = 255;
+
+    if(pressureWidth) {
+      s.radius = PRESSURE_RADIUS[0] + s.pressure * (PRESSURE_RADIUS[1] - PRESSURE_RADIUS[0]);
+      s.alpha = (Uint8) (PRESSURE_ALPHA[0] + s.pressure * (PRESSURE_ALPHA[1] - PRESSURE_ALPHA[0]));
+    }
+
+    if(n == restart)
+      predictor.reset();
+    predictor.add(s.timestamp, s.x, s.y, s.drained);
+  }
+
+  latest = samples.back();
+  mapped = samples.size();
+}
+
+//rasterize the pending path in one pass, true if anything was drawn.
+//continued when path starts on the segment drawn last
+bool drawPath(Stroke & stroke, Uint32 color, bool continued) {
+  if(path.empty())
+    return false;
+
+  stroke.polyline(canvas, path, color, continued);
+
+  hasTail = path.size() > 1;
+  if(hasTail)
+    tail = path[path.size() - 2];
+
+  path.clear();
+  return true;
+}
+
+//how hard v pushes against either end of 0..size, -1 to 1
+float edgePush(float v, int size) {
+  if(v < PAN_EDGE)
+    return -std::min((PAN_EDGE - v) / PAN_EDGE, 1.0f);
+  if(v > size - PAN_EDGE)
+    return std::min((v - size + PAN_EDGE) / PAN_EDGE, 1.0f);
+  return 0;
+}
+
+//scroll the view while the cursor at x, y is held against an edge, a
+//stroke being drawn carries on onto the newly uncovered canvas
+void panView(float x, float y) {
+  Uint64 now = SDL_GetPerformanceCounter();
+  float dt = panStep == 0 ? 0 :
+      std::min((float) (now - panStep) / SDL_GetPerformanceFrequency(), PAN_MAX_STEP);
+
+  float dx = edgePush(x, SCREEN_WIDTH);
+  float dy = edgePush(y, SCREEN_HEIGHT);
+  if(dx == 0 && dy == 0) {
+    panStep = 0;
+    return;
+  }
+  panStep = now;
+
+  SDL_Rect room = canvas.extent();
+  panX = std::max((float) room.x, std::min(panX + dx * PAN_SPEED * dt, (float) (room.x + room.w - SCREEN_WIDTH)));
+  panY = std::max((float) room.y, std::min(panY + dy * PAN_SPEED * dt, (float) (room.y + room.h - SCREEN_HEIGHT)));
+  canvas.pan((int) std::floor(panX), (int) std::floor(panY));
+}
+
+//milliseconds from a performance counter reading to now
+double millisSince(Uint64 from) {
+  return (SDL_GetPerformanceCounter() - from) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
 int main(int argc, char * argv[]) {
 
-  //init Myo
+  //time to first frame counts from here
+  Uint64 launched = SDL_GetPerformanceCounter();
+
+  Options opts;
+  if(parseOptions(argc, argv, opts))
+    return -1;
+
+  if(opts.bench == "stroke")
+    return benchStroke();
+  if(opts.bench == "pointer")
+    return benchPointer();
+  if(opts.bench == "filter")
+    return benchFilter(opts);
+  if(opts.bench == "fusion")
+    return benchFusion(opts);
+  if(opts.bench == "drift")
+    return benchDrift(opts);
+  if(opts.bench == "emg")
+    return benchEmg(opts);
+  if(opts.bench == "log")
+    return benchLog();
+
+  //console output from the frame loop and the armband's callbacks is
+  //written by its own thread from here on
+  logger.level = logLevel(opts.logLevel);
+  if(logger.start())
+    return -1;
+
+  //init input
   // We catch any exceptions that might occur below -- see the catch statement for more details.
   try {
-    // First, we create a Hub with our application identifier. Be sure not to use the com.example namespace when
-    // publishing your application. The Hub provides access to one or more Myos.
-    myo::Hub hub("com.example.myoSign");
-    //hub.setLockingPolicy(libmyo_locking_policy_none);
-    hub.setLockingPolicy(myo::Hub::lockingPolicyNone);
-
-    std::cout << "Attempting to find a Myo..." << std::endl;
-    // Next, we attempt to find a Myo to use. If a Myo is already paired in Myo Connect, this will return that Myo
-    // immediately.
-    // waitForMyo() takes a timeout value in milliseconds. In this case we will try to find a Myo for 10 seconds, and
-    // if that fails, the function will return a null pointer.
-    myo::Myo* myo = hub.waitForMyo(10000);
-    // If waitForMyo() returned a null pointer, we failed to find a Myo, so exit with an error message.
-    if (!myo) {
-        throw std::runtime_error("Unable to find a Myo!");
+    LatencyProbe probe;
+    std::unique_ptr<InputSource> input(openSource(opts, probe));
+
+    filter.type = filterType(opts.filter);
+    filter.minCutoff = opts.minCutoff;
+    filter.beta = opts.beta;
+    input->smooth(&filter);
+
+    driftCorrect = opts.drift;
+    fusion.enabled = opts.fusion;
+    input->fuse(&fusion);
+
+    //the latency probe looks for its cursor at fixed places on screen
+    edgePan = opts.pan == "edge" && opts.probe == 0;
+
+    pressureWidth = opts.pressure == "emg";
+    grip.enabled = pressureWidth;
+    input->measure(&grip);
+
+    if(opts.poses == "emg") {
+      if(!gestures.classifier.load(opts.gestureModel))
+        throw std::runtime_error("Unable to load " + opts.gestureModel + ", train one with --bench-emg");
+      gestures.enabled = true;
+      input->classify(&gestures);
+    }
+
+    // Everything the source sends is queued from here on, the drawing loop rebuilds its view of it.
+    InputState state;
+
+    //tracing has to be on before any thread records into it
+    if(!opts.trace.empty()) {
+      if(!tracer.open(opts.trace))
+        throw std::runtime_error("Unable to write " + opts.trace);
+      tracer.nameThread("main");
+    }
+
+    Recorder recorder;
+    if(!opts.record.empty()) {
+      if(!recorder.open(opts.record))
+        throw std::runtime_error("Unable to write " + opts.record);
+      input->record(&recorder);
     }
-    // We've found a Myo.
-    std::cout << "Connected to a Myo armband!" << std::endl << std::endl;
-    // Next we construct an instance of our DeviceListener, so that we can register it with the Hub.
-    DataCollector collector;
-    // Hub::addListener() takes the address of any object whose class inherits from DeviceListener, and will cause
-    // Hub::run() to send events to all registered device listeners.
-    hub.addListener(&collector);
+
+  //offscreen frames have no display to wait for
+  int pacing = pacingMode(opts.pacing);
+  if(opts.headless && pacing == PACING_VSYNC)
+    pacing = PACING_UNCAPPED;
 
   Display disp;
-  if(disp.init()) {
+  if(disp.init(opts.headless, pacing == PACING_VSYNC)) {
     cout << "Init Error" << endl;
     return -1;
   }
+  double windowMs = millisSince(launched);
+
+  if(!opts.canvasFile.empty() &&
+      canvas.open(opts.canvasFile, opts.canvasSize, (size_t) opts.canvasMemory << 20)) {
+    cout << "Canvas Error" << endl;
+    return -1;
+  }
 
   if(disp.load()) {
     cout << "Load Error" << endl;
     return -1;
   }
+  double loadMs = millisSince(launched);
+
+  //the input thread wakes an idle loop with this
+  Uint32 wakeEvent = SDL_RegisterEvents(1);
+  if(wakeEvent == (Uint32) -1)
+    wakeEvent = SDL_USEREVENT;
+
+  //offscreen runs and the latency probe want every frame drawn
+  bool idle = opts.idle && !opts.headless && opts.probe == 0;
+
+  FrameScheduler scheduler;
+  double refresh = disp.refreshRate();
+  scheduler.start(pacing, pacing == PACING_FIXED && opts.fps > 0 ? opts.fps : refresh);
+  if(pacing == PACING_UNCAPPED)
+    cout << "Frames uncapped" << endl;
+  else
+    cout << "Pacing frames " << PACING_NAMES[pacing] << " at " << scheduler.rate << " Hz" << endl;
+
+  //the armband comes and goes without holding up the window
+  bool myo = opts.source == "myo" && opts.probe == 0;
+  bool paired = false;
+  if(myo)
+    disp.status("looking for a Myo");
 
   int quit = 0;
   int frames = 0;
+  unsigned int totalFrames = 0;
+
+  Stroke stroke;
 
   int i = 255;
   int j = 0;
   int k = 0;
 
   mouseRect = {0, 0, 10, 10};
+
+  //source runs on its own thread from here on
+  if(input->start()) {
+    cout << "Input Error" << endl;
+    return -1;
+  }
+
   unsigned int begin = SDL_GetTicks();
+  unsigned int start = begin;
+
+  if(!opts.profile.empty())
+    profiler.exportTo(opts.profile, opts.profileEvery);
+
+  unsigned int missed = 0;
 
   //main loop
   while(!quit) {
+    //fixed pacing sleeps until this frame is due, vsync waits in present
+    profiler.begin(STAGE_PACE);
+    scheduler.wait();
+    profiler.end(STAGE_PACE);
+
+    profiler.begin(STAGE_FRAME);
+
     //fps counter
     if(SDL_GetTicks() - begin > 1000) {
       begin = SDL_GetTicks();
-      cout << "FPS: " << frames << endl;
+      logger.write(LOG_INFO, "FPS: %g, %g missed", frames, scheduler.missed - missed);
       frames = 0;
+      missed = scheduler.missed;
     }
 
-    //check for end loop
-    if(disp.handleEvents() == -1)
+    //check for end loop, closing the frame's spans so the trace stays balanced
+    profiler.begin(STAGE_EVENTS);
+    int handled = disp.handleEvents();
+    profiler.end(STAGE_EVENTS);
+    if(handled == -1) {
+      profiler.end(STAGE_FRAME);
       break;
+    }
 
-    //handle myo events
-    hub.run(1);
+    //take every input event queued since the last frame, keeping the
+    //armband state after each one so the whole path can be drawn
+    //(anything latched for last frame's cursor is still at the front)
+    tracer.counter("queue_depth", input->pending());
+    profiler.begin(STAGE_INPUT);
+    drain(*input, state, opts.probe > 0 ? &probe : NULL, totalFrames + 1);
+
+    if(myo && state.paired != paired) {
+      paired = state.paired;
+      if(paired)
+        logger.write(LOG_INFO, "Myo paired after %.0f ms", millisSince(launched));
+      else
+        logger.write(LOG_WARN, "Myo unpaired, waiting for it to pair again");
+      disp.status(paired ? "" : "looking for a Myo");
+    }
 
-    //collector.print();
+    //nothing new, hold where the arm was last frame
+    if(samples.empty())
+      samples.push_back(sample(state));
+    profiler.end(STAGE_INPUT);
+
+    //calculate myo positions
+    profiler.begin(STAGE_MAP);
+    mapSamples();
+    profiler.end(STAGE_MAP);
+
+    //walk the poses in order, each run of fist samples becomes one polyline
+    //in canvas coordinates
+    profiler.begin(STAGE_STROKE);
+    if(edgePan)
+      panView(latest.x, latest.y);
+    float viewX = canvas.viewX();
+    float viewY = canvas.viewY();
+
+    Uint32 color = canvas.mapRGB(i, j, k);
+    bool drew = false;
+    bool continued = false;
+    path.clear();
+
+    for(size_t s = 0; s < samples.size(); s++) {
+      const Sample & p = samples[s];
+
+      switch(p.pose) {
+        case POSE_FIST:
+          if(firstFist) {
+            lastX = p.x + viewX;
+            lastY = p.y + viewY;
+            lastRadius = p.radius;
+            lastAlpha = p.alpha;
+            hasTail = false;
+            firstFist = false;
+          }
+          if(path.empty()) {
+            continued = hasTail && pressureWidth;
+            if(continued)
+              path.push_back(tail);
+            path.push_back({lastX, lastY, lastRadius, lastAlpha});
+          }
+          path.push_back({p.x + viewX, p.y + viewY, p.radius, p.alpha});
+
+          lastX = p.x + viewX;
+          lastY = p.y + viewY;
+          lastRadius = p.radius;
+          lastAlpha = p.alpha;
+          break;
+        case POSE_SPREAD:
+          //clear drawings, anything still unpainted would be wiped anyway
+          path.clear();
+          canvas.clear();
+          hasTail = false;
+          break;
+        case POSE_TAP:
+          drew |= drawPath(stroke, color, continued);
+          lastX = p.x + viewX;
+          lastY = p.y + viewY;
+          lastRadius = p.radius;
+          lastAlpha = p.alpha;
+          hasTail = false;
+          break;
+        case POSE_OTHER:
+          drew |= drawPath(stroke, color, continued);
+          firstFist = true;
+          break;
+      }
+    }
+    drew |= drawPath(stroke, color, continued);
 
-    //calculate myo position
-    int x;
-    if(xInvert)
-      x = (collector.getYaw() - 900) * X_SENS * SCREEN_WIDTH / 1800.0 + 900 * SCREEN_WIDTH / 1800.0;
-    else
-      x = (900 - collector.getYaw()) * X_SENS * SCREEN_WIDTH / 1800.0 + 900 * SCREEN_WIDTH / 1800.0;
-    int y;
+    //color cycles once per frame drawn
+    if(drew) {
+      if(i == 255 && j < 255 && k == 0) {
+        j++;
+      }
+      else if(i > 0 && j == 255) {
+        i--;
+      }
+      else if(j == 255 && k < 255) {
+        k++;
+      }
+      else if(j > 0 && k == 255) {
+        j--;
+      }
+      else if(k == 255 && i < 255) {
+        i++;
+      }
+      else {
+        k--;
+      }
+    }
+    samples.clear();
+    mapped = 0;
+    profiler.end(STAGE_STROKE);
+
+    //a frame that would look like the last one isn't drawn at all, though
+    //the cursor can still move it once input is latched
+    bool stale = !idle || disp.stale();
+    if(stale && disp.visible())
+      disp.compose();
+
+    //re-sample the input right before the cursor goes on, these samples
+    //are drawn into the canvas next frame
+    profiler.begin(STAGE_LATCH);
+    drain(*input, state, opts.probe > 0 ? &probe : NULL, totalFrames + 1);
+    mapSamples();
+    Sample cursor = latest;
+
+    //aim for when this frame will actually be shown
+    Uint64 latched = SDL_GetPerformanceCounter();
+    if(opts.predict != "off")
+      predictor.predict(latched + predictor.lead(), cursor.x, cursor.y);
+
+    tipRects.clear();
+    if(opts.predict == "tip" && cursor.pose == POSE_FIST && !firstFist) {
+      std::vector<StrokePoint> tip;
+      tip.push_back({lastX - viewX, lastY - viewY, lastRadius});
+      tip.push_back({cursor.x, cursor.y, cursor.radius});
+      stroke.spans(tip, SCREEN_WIDTH, SCREEN_HEIGHT, tipRects);
+      tipColor = {(Uint8) i, (Uint8) j, (Uint8) k, 0xFF};
+    }
 
-    if(yInvert)
-      y = (collector.getPitch() - 900) * Y_SENS * SCREEN_HEIGHT / 1800.0 + 900 * SCREEN_HEIGHT / 1800.0;
-    else
-      y = (900 - collector.getPitch()) * Y_SENS * SCREEN_HEIGHT / 1800.0 + 900 * SCREEN_HEIGHT / 1800.0;
-    
-    //cout << x << " " << y << endl;
-    //collector.print();
+    int x = cursor.x;
+    int y = cursor.y;
+    pointerRect = {x - 8, y - 8, 16, 16};
+    profiler.end(STAGE_LATCH);
+
+    bool show = disp.visible() && (stale || disp.moved());
+    if(show) {
+      if(!stale)
+        disp.compose();
+      disp.present();
+      scheduler.presented();
+      predictor.presented(latched);
+      frames++;
+      totalFrames++;
+    }
+    profiler.end(STAGE_FRAME);
+
+    //sleep until the user or the armband does something, or the window
+    //comes back
+    if(!show) {
+      scheduler.skipped();
+      tracer.begin("idle");
+      if(input->wakeOnPush(wakeEvent))
+        disp.wait(IDLE_WAIT_MS);
+      tracer.end("idle");
+    }
 
-    //get myo pose
-    int pose = collector.getPose();
+    if(show && totalFrames == 1)
+      logger.write(LOG_INFO, "First frame after %.1f ms (window %.1f ms, assets %.1f ms)",
+          millisSince(launched), windowMs, loadMs - windowMs);
 
-    SDL_Rect rect2 = {x, y, (collector.getRoll()) / 200, (collector.getRoll()) / 200};
-    //SDL_Rect rect3 = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    //pixels can only be read back reliably from the offscreen target
+    if(show && opts.probe > 0) {
+      Uint32 sum = opts.headless ? disp.checksum(LatencyProbe::band(SCREEN_WIDTH, SCREEN_HEIGHT)) : 0;
+      probe.presented(totalFrames, opts.headless, sum);
+    }
 
-    switch(pose) {
-      case POSE_FIST:
+    profiler.tick();
+    tracer.flush();
 
-        if(firstFist) {
-          lastX = x;
-          lastY = y;
-          firstFist = false;
-        }
-        //draw to screen
-        while(rect2.x != lastX || rect2.y != lastY) {
-          SDL_FillRect(drawSurface, &rect2, SDL_MapRGB(drawSurface->format, i, j, k));
-          if(rect2.x < lastX) rect2.x += 1;
-          else if(rect2.x > lastX) rect2.x -= 1;
-
-          if(rect2.y < lastY) rect2.y += 1;
-          else if(rect2.y > lastY) rect2.y -= 1;
-        }
+    if(show && opts.dumpEvery > 0 && totalFrames % opts.dumpEvery == 0) {
+      char name[32];
+      snprintf(name, sizeof(name), "/frame%06u.png", totalFrames);
+      disp.saveFrame(opts.dumpDir + name);
+    }
 
+    //headless runs end with their input or after a fixed number of frames
+    if(opts.frames > 0 && totalFrames >= opts.frames)
+      quit = 1;
+    if((opts.headless || opts.probe > 0) && input->finished())
+      quit = 1;
+  }
 
-        if(i == 255 && j < 255 && k == 0) {
-          j++;
-        }
-        else if(i > 0 && j == 255) {
-          i--;
-        }
-        else if(j == 255 && k < 255) {
-          k++;
-        }
-        else if(j > 0 && k == 255) {
-          j--;
-        }
-        else if(k == 255 && i < 255) {
-          i++;
-        }
-        else {
-          k--;
-        }
+  //everything logged from the loop comes out before the summary
+  logger.stop();
 
-        lastX = x;
-        lastY = y;
+  unsigned int elapsed = SDL_GetTicks() - start;
+  cout << totalFrames << " frames in " << elapsed << " ms";
+  if(totalFrames > 0)
+    cout << " (" << (double) elapsed / totalFrames << " ms/frame)";
+  if(pacing != PACING_UNCAPPED)
+    cout << ", " << scheduler.missed << " missed deadlines";
+  cout << endl;
 
-        break;
-      case POSE_SPREAD:
-        //clear drawings
-        SDL_FillRect(drawSurface, NULL, SDL_MapRGB(drawSurface->format, 0, 0, 0));
-        break;
-      case POSE_TAP:
-        lastX = x;
-        lastY = y;
-        break;
-      case POSE_OTHER:
-        firstFist = true;
-        break;
-    }
+  //grows with what was painted, not with how far the view went
+  printf("Canvas %u tiles, %.1f MB\n", (unsigned int) canvas.tiles(), canvas.bytes() / 1048576.0);
 
-    pointerRect = {x - 8, y - 8, 16, 16};
-    disp.render();
-    frames++;
+  if(!opts.profile.empty()) {
+    profiler.finish();
+    profiler.print();
   }
 
+  if(opts.probe > 0)
+    probe.report();
+
+  input->stop();
+  tracer.close();
+
+  //the canvas file gets its last tiles as the display stops
+  bool backed = canvas.store.isOpen();
   disp.stop();
+  if(backed)
+    printf("Canvas file %u tiles read, %u written, %u lost\n", canvas.store.loads,
+        canvas.store.saves, canvas.store.failed.load());
+
+  if(!opts.record.empty()) {
+    recorder.close();
+    cout << "Recorded " << recorder.count() << " events to " << opts.record << endl;
+  }
 
   //TODO clear change
   } catch (const std::exception& e) {
+    logger.stop();
     std::cerr << "Error: " << e.what() << std::endl;
     std::cerr << "Press enter to continue.";
     std::cin.ignore();
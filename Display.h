@@ -19,12 +19,39 @@
 
 class Display{
   public:
-  	int init();
+  	int init(bool headless, bool vsync);
   	int load();
   	int handleEvents();
-  	void render();
+  	void upload();
+  	void compose();
+  	void present();
   	void stop();
 
+    //false while the window is minimized or hidden
+    bool visible();
+
+    //the canvas changed or the window needs repainting since the last
+    //present
+    bool stale();
+
+    //the cursors or predicted tip aren't where the last present put them
+    bool moved();
+
+    //sleep until an SDL event is queued or timeout ms pass
+    void wait(Uint32 timeout);
+
+    //PNG of the last rendered frame
+    int saveFrame(std::string path);
+
+    //hash of part of the last rendered frame
+    Uint32 checksum(const SDL_Rect & area);
+
+    //shown after the name in the title bar, empty for just the name
+    void status(const std::string & text);
+
+    //of the display the window is on, 60 when it can't be told
+    double refreshRate();
+
     SDL_Texture * loadTexture(std::string path);
     
 };
@@ -0,0 +1,148 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Drift.cpp
+ Description:   Estimates the armband's slow yaw drift while the arm is held
+                still and turns it into a correction of the pointer's center.
+ *****************************************************************************/
+
+#include "Drift.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <algorithm>
+
+//a window counts as still when the arm wobbles less than this about a
+//straight line, radians, and turns slower than any real drift could
+const double STILL_SPREAD = 0.005;
+const double STILL_RATE = 0.005;
+
+//weight of each still window in the drift estimate
+const double DRIFT_GAIN = 0.1;
+
+//a gap this long means the stream restarted
+const uint64_t DRIFT_GAP_US = 1000000;
+
+DriftEstimator::DriftEstimator()
+: stills(0), previous(0), primed(false), base(0), last(0), heading(0), drift(0), correction(0) {
+  restart();
+}
+
+void DriftEstimator::restart() {
+  head = 0;
+  count = 0;
+  fresh = 0;
+  added = 0;
+  streak = 0;
+  st = sy = stt = sty = syy = su = suu = 0;
+  primed = false;
+}
+
+void DriftEstimator::recenter() {
+  correction = 0;
+}
+
+void DriftEstimator::add(uint64_t timestamp, const float quat[4]) {
+  if(primed && timestamp <= last)
+    return;
+  if(primed && timestamp - last > DRIFT_GAP_US)
+    restart();
+
+  float w = quat[0], x = quat[1], y = quat[2], z = quat[3];
+
+  //forearm direction, the armband's x axis in the world
+  double fx = 1 - 2 * (y * y + z * z);
+  double fy = 2 * (x * y + w * z);
+  double fz = 2 * (x * z - w * y);
+
+  //unwrapped so a turn through +-pi stays continuous
+  double h = std::atan2(fy, fx);
+  if(!primed) {
+    base = timestamp;
+    heading = h;
+  }
+  else {
+    correction += drift * (timestamp - last) / 1000000.0;
+    double step = h - std::remainder(heading, 2 * M_PI);
+    heading += std::remainder(step, 2 * M_PI);
+  }
+  primed = true;
+  last = timestamp;
+
+  Entry e = {(timestamp - base) / 1000000.0, heading, fz};
+
+  //slide the window, the sums follow in O(1)
+  if(count == DRIFT_WINDOW) {
+    const Entry & old = ring[head];
+    st -= old.t;
+    sy -= old.yaw;
+    stt -= old.t * old.t;
+    sty -= old.t * old.yaw;
+    syy -= old.yaw * old.yaw;
+    su -= old.up;
+    suu -= old.up * old.up;
+  }
+  else {
+    count++;
+  }
+
+  ring[head] = e;
+  head = (head + 1) % DRIFT_WINDOW;
+
+  st += e.t;
+  sy += e.yaw;
+  stt += e.t * e.t;
+  sty += e.t * e.yaw;
+  syy += e.yaw * e.yaw;
+  su += e.up;
+  suu += e.up * e.up;
+
+  //rebuild now and then so rounding in the running sums can't build up
+  if(++added >= DRIFT_WINDOW * 64) {
+    added = 0;
+    st = sy = stt = sty = syy = su = suu = 0;
+    for(int n = 0; n < count; n++) {
+      const Entry & r = ring[n];
+      st += r.t;
+      sy += r.yaw;
+      stt += r.t * r.t;
+      sty += r.t * r.yaw;
+      syy += r.yaw * r.yaw;
+      su += r.up;
+      suu += r.up * r.up;
+    }
+  }
+
+  //judge the full window every eighth of it
+  if(++fresh < DRIFT_WINDOW / 8 || count < DRIFT_WINDOW)
+    return;
+  fresh = 0;
+
+  //least squares line through yaw over time, and what is left around it
+  double n = count;
+  double ctt = stt - st * st / n;
+  double cty = sty - st * sy / n;
+  double cyy = syy - sy * sy / n;
+  double cuu = suu - su * su / n;
+  if(ctt <= 0)
+    return;
+
+  double slope = cty / ctt;
+  double wobble = std::max(0.0, cyy - slope * cty) / n;
+  double bob = std::max(0.0, cuu) / n;
+
+  if(wobble > STILL_SPREAD * STILL_SPREAD || bob > STILL_SPREAD * STILL_SPREAD ||
+      std::fabs(slope) > STILL_RATE) {
+    streak = 0;
+    return;
+  }
+
+  //only trust a window whose neighbours were still too, so the tail of a
+  //movement at either edge can't pass for drift
+  if(++streak >= 3) {
+    drift += DRIFT_GAIN * (previous - drift);
+    stills++;
+  }
+  previous = slope;
+}
@@ -0,0 +1,67 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Drift.h
+ Description:   Estimates the armband's slow yaw drift while the arm is held
+                still and turns it into a correction of the pointer's center.
+ *****************************************************************************/
+
+
+#include <stdint.h>
+
+#ifndef DRIFT_H
+#define DRIFT_H
+
+//samples in the sliding window, about 2.5 s at the armband's 50 Hz
+const int DRIFT_WINDOW = 128;
+
+class DriftEstimator{
+  public:
+    DriftEstimator();
+
+    //one orientation sample, w, x, y, z, in timestamp order
+    void add(uint64_t timestamp, const float quat[4]);
+
+    //the pointer was recentered, drift so far is part of the new center
+    void recenter();
+
+    //yaw the center should be turned by, radians
+    float offset() { return (float) correction; }
+
+    //estimated drift, rad/s
+    float rate() { return (float) drift; }
+
+    //still windows that went into the estimate
+    unsigned int stills;
+
+  private:
+    void restart();
+
+    struct Entry {
+      double t;     //seconds since base
+      double yaw;   //unwrapped forearm heading, radians
+      double up;    //vertical part of the forearm direction
+    };
+
+    Entry ring[DRIFT_WINDOW];
+    int head;
+    int count;
+    int fresh;      //samples added since the window was last judged
+    int added;      //since the sums were last rebuilt
+    int streak;     //still windows in a row
+    double previous;  //slope of the last still window
+
+    //running sums over the window
+    double st, sy, stt, sty, syy, su, suu;
+
+    bool primed;
+    uint64_t base;
+    uint64_t last;
+    double heading;
+
+    double drift;
+    double correction;
+};
+
+#endif /* DRIFT_H */
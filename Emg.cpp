@@ -0,0 +1,137 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Emg.cpp
+ Description:   Sliding window features of the armband's eight EMG channels,
+                updated in O(1) per sample with SSE2 when it is available.
+ *****************************************************************************/
+
+#include "Emg.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//a sign change only counts as a crossing if the signal moved at least this
+//far, so the idle noise floor doesn't count
+const int16_t EMG_CROSS_STEP = 4;
+
+EmgWindow::EmgWindow() {
+#ifdef __SSE2__
+  simd = true;
+#else
+  simd = false;
+#endif
+  reset();
+}
+
+void EmgWindow::reset() {
+  memset(ring, 0, sizeof(ring));
+  memset(crossed, 0, sizeof(crossed));
+  memset(previous, 0, sizeof(previous));
+  memset(squares, 0, sizeof(squares));
+  memset(absolute, 0, sizeof(absolute));
+  memset(crossings, 0, sizeof(crossings));
+  head = 0;
+  count = 0;
+}
+
+void EmgWindow::add(const int8_t emg[EMG_CHANNELS]) {
+  int16_t x[EMG_CHANNELS];
+  for(int c = 0; c < EMG_CHANNELS; c++)
+    x[c] = emg[c];
+
+  //nothing to cross from yet
+  if(count == 0)
+    memcpy(previous, x, sizeof(previous));
+
+  //the slot at head is zero until the window fills, so leaving it costs nothing
+  if(simd)
+    addSse2(x);
+  else
+    addScalar(x);
+
+  head = (head + 1) % EMG_WINDOW;
+  if(count < EMG_WINDOW)
+    count++;
+}
+
+void EmgWindow::addScalar(const int16_t * x) {
+  int16_t * old = ring[head];
+  int16_t * oldCrossed = crossed[head];
+
+  for(int c = 0; c < EMG_CHANNELS; c++) {
+    int16_t p = previous[c];
+    int16_t step = (int16_t) (x[c] - p);
+    int16_t cross = ((x[c] ^ p) < 0 && (step > EMG_CROSS_STEP || -step > EMG_CROSS_STEP)) ? 1 : 0;
+
+    squares[c] += x[c] * x[c] - old[c] * old[c];
+    absolute[c] += (int16_t) ((x[c] < 0 ? -x[c] : x[c]) - (old[c] < 0 ? -old[c] : old[c]));
+    crossings[c] += (int16_t) (cross - oldCrossed[c]);
+
+    old[c] = x[c];
+    oldCrossed[c] = cross;
+    previous[c] = x[c];
+  }
+}
+
+#ifdef __SSE2__
+
+//all eight channels are one register of int16
+static inline __m128i abs16(__m128i v) {
+  return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+}
+
+void EmgWindow::addSse2(const int16_t * x) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i v = _mm_loadu_si128((const __m128i *) x);
+  __m128i p = _mm_loadu_si128((const __m128i *) previous);
+  __m128i old = _mm_loadu_si128((const __m128i *) ring[head]);
+  __m128i oldCrossed = _mm_loadu_si128((const __m128i *) crossed[head]);
+
+  //signs differ and the step is big enough, as 0 or 1 per channel
+  __m128i flipped = _mm_cmplt_epi16(_mm_xor_si128(v, p), zero);
+  __m128i big = _mm_cmpgt_epi16(abs16(_mm_sub_epi16(v, p)), _mm_set1_epi16(EMG_CROSS_STEP));
+  __m128i cross = _mm_srli_epi16(_mm_and_si128(flipped, big), 15);
+
+  __m128i * sumAbs = (__m128i *) absolute;
+  __m128i * sumCross = (__m128i *) crossings;
+  _mm_storeu_si128(sumAbs, _mm_add_epi16(_mm_loadu_si128(sumAbs), _mm_sub_epi16(abs16(v), abs16(old))));
+  _mm_storeu_si128(sumCross, _mm_add_epi16(_mm_loadu_si128(sumCross), _mm_sub_epi16(cross, oldCrossed)));
+
+  //squares fit int16 but their sums need int32, widen each half
+  __m128i square = _mm_mullo_epi16(v, v);
+  __m128i oldSquare = _mm_mullo_epi16(old, old);
+  __m128i * low = (__m128i *) squares;
+  __m128i * high = (__m128i *) (squares + 4);
+  __m128i addLow = _mm_sub_epi32(_mm_unpacklo_epi16(square, zero), _mm_unpacklo_epi16(oldSquare, zero));
+  __m128i addHigh = _mm_sub_epi32(_mm_unpackhi_epi16(square, zero), _mm_unpackhi_epi16(oldSquare, zero));
+  _mm_storeu_si128(low, _mm_add_epi32(_mm_loadu_si128(low), addLow));
+  _mm_storeu_si128(high, _mm_add_epi32(_mm_loadu_si128(high), addHigh));
+
+  _mm_storeu_si128((__m128i *) ring[head], v);
+  _mm_storeu_si128((__m128i *) crossed[head], cross);
+  _mm_storeu_si128((__m128i *) previous, v);
+}
+
+#else
+
+void EmgWindow::addSse2(const int16_t * x) {
+  addScalar(x);
+}
+
+#endif
+
+void EmgWindow::features(float out[EMG_FEATURES]) {
+  float n = count > 0 ? (float) count : 1.0f;
+
+  for(int c = 0; c < EMG_CHANNELS; c++) {
+    out[c] = std::sqrt(squares[c] / n);
+    out[EMG_CHANNELS + c] = absolute[c] / n;
+    out[2 * EMG_CHANNELS + c] = crossings[c] / n;
+  }
+}
@@ -0,0 +1,58 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Emg.h
+ Description:   Sliding window features of the armband's eight EMG channels,
+                updated in O(1) per sample with SSE2 when it is available.
+ *****************************************************************************/
+
+
+#include <stdint.h>
+#include "Input.h"
+
+#ifndef EMG_H
+#define EMG_H
+
+//160 ms at the armband's 200 Hz, short enough that a fist shows up early
+const int EMG_WINDOW = 32;
+
+//rms, mav and zero crossings of every channel
+const int EMG_FEATURES = 3 * EMG_CHANNELS;
+
+class EmgWindow{
+  public:
+    EmgWindow();
+
+    void reset();
+
+    //one sample of every channel
+    void add(const int8_t emg[EMG_CHANNELS]);
+
+    bool full() { return count == EMG_WINDOW; }
+
+    //rms, then mean absolute value, then zero crossings per sample, each
+    //for channels 0 to 7
+    void features(float out[EMG_FEATURES]);
+
+    //SSE2 kernel when built with it, the scalar loop otherwise. Both keep
+    //exactly the same sums
+    bool simd;
+
+  private:
+    void addScalar(const int16_t * x);
+    void addSse2(const int16_t * x);
+
+    int16_t ring[EMG_WINDOW][EMG_CHANNELS];     //samples in the window
+    int16_t crossed[EMG_WINDOW][EMG_CHANNELS];  //1 where a sample crossed zero
+    int16_t previous[EMG_CHANNELS];
+    int head;
+    int count;
+
+    //running sums over the window, int16 holds EMG_WINDOW * 128
+    int32_t squares[EMG_CHANNELS];
+    int16_t absolute[EMG_CHANNELS];
+    int16_t crossings[EMG_CHANNELS];
+};
+
+#endif /* EMG_H */
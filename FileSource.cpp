@@ -0,0 +1,84 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     FileSource.cpp
+ Description:   Plays armband events back from a recording file.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "FileSource.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+FileSource::FileSource(const std::string & path, float speed)
+: path(path), speed(speed), binary(false) {}
+
+FileSource::~FileSource() {
+  stop();
+}
+
+bool FileSource::open() {
+  binary = Recording::isRecording(path);
+  if(binary)
+    return recording.open(path);
+
+  std::ifstream file(path.c_str());
+  return file.good();
+}
+
+void FileSource::run() {
+  if(binary)
+    runBinary();
+  else
+    runText();
+}
+
+void FileSource::runBinary() {
+  InputEvent e;
+
+  while(running && recording.next(e)) {
+    pace(e.timestamp, speed);
+    if(!pushWait(e))
+      break;
+  }
+}
+
+void FileSource::runText() {
+  std::ifstream file(path.c_str());
+  std::string line;
+  int lineNumber = 0;
+
+  while(running && std::getline(file, line)) {
+    lineNumber++;
+
+    if(line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream fields(line);
+    InputEvent e = {0, 0, 0, {1, 0, 0, 0}, {0}};
+
+    if(!(fields >> e.timestamp >> e.type >> e.value)) {
+      std::cerr << path << ":" << lineNumber << ": bad event" << std::endl;
+      continue;
+    }
+
+    //EMG lines carry the eight channels where the others carry a quaternion
+    if(e.type == EVENT_EMG) {
+      for(int c = 0; c < EMG_CHANNELS; c++) {
+        int v = 0;
+        fields >> v;
+        e.emg[c] = (int8_t) v;
+      }
+    }
+    else {
+      fields >> e.quat[0] >> e.quat[1] >> e.quat[2] >> e.quat[3];
+    }
+
+    pace(e.timestamp, speed);
+    if(!pushWait(e))
+      break;
+  }
+}
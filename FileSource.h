@@ -0,0 +1,43 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     FileSource.h
+ Description:   Plays armband events back from a recording file.
+ *****************************************************************************/
+
+
+#include <string>
+#include "InputSource.h"
+
+#ifndef FILESOURCE_H
+#define FILESOURCE_H
+
+//binary recordings (see Recording.h) are memory mapped, anything else is
+//read as text with one event per line:
+//  timestamp type value w x y z
+//or for EMG
+//  timestamp 9 0 e0 e1 e2 e3 e4 e5 e6 e7
+//with type and value as in Input.h, blank lines and # comments are skipped
+class FileSource : public InputSource {
+  public:
+    FileSource(const std::string & path, float speed);
+    ~FileSource();
+
+    //false if the file can't be opened
+    bool open();
+
+  protected:
+    void run();
+
+  private:
+    void runText();
+    void runBinary();
+
+    std::string path;
+    float speed;
+    bool binary;
+    Recording recording;
+};
+
+#endif /* FILESOURCE_H */
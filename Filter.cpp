@@ -0,0 +1,121 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Filter.cpp
+ Description:   Orientation smoothing run on the input thread before events
+                are queued, tunable from the drawing loop while running.
+ *****************************************************************************/
+
+#include "Filter.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+const char * FILTER_NAMES[FILTER_TYPES] = {"none", "euro", "slerp"};
+
+//a gap this long means the stream restarted, don't smooth across it
+const uint64_t FILTER_GAP_US = 1000000;
+
+int filterType(const std::string & name) {
+  for(int n = 0; n < FILTER_TYPES; n++)
+    if(name == FILTER_NAMES[n])
+      return n;
+  return -1;
+}
+
+//weight of a new sample for a first order low pass at cutoff Hz
+static float alpha(float cutoff, float dt) {
+  float tau = 1.0f / (2 * (float) M_PI * cutoff);
+  return dt / (dt + tau);
+}
+
+//rotation angle between two unit quaternions
+static float angle(const float * a, const float * b) {
+  //vector part of conj(a) * b
+  float x = a[0] * b[1] - a[1] * b[0] - a[2] * b[3] + a[3] * b[2];
+  float y = a[0] * b[2] + a[1] * b[3] - a[2] * b[0] - a[3] * b[1];
+  float z = a[0] * b[3] - a[1] * b[2] + a[2] * b[1] - a[3] * b[0];
+  float w = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+  return 2 * std::atan2(std::sqrt(x * x + y * y + z * z), std::fabs(w));
+}
+
+//a moved fraction t of the way to b along the shorter arc
+static void slerp(float * a, const float * b, float t) {
+  float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+  float sign = dot < 0 ? -1.0f : 1.0f;
+  dot *= sign;
+
+  float wa = 1 - t;
+  float wb = t;
+
+  //nearly parallel, the normalized lerp below is as good
+  if(dot < 0.9995f) {
+    float theta = std::acos(dot);
+    float s = std::sin(theta);
+    wa = std::sin(wa * theta) / s;
+    wb = std::sin(wb * theta) / s;
+  }
+
+  float len = 0;
+  for(int n = 0; n < 4; n++) {
+    a[n] = wa * a[n] + wb * sign * b[n];
+    len += a[n] * a[n];
+  }
+
+  len = 1 / std::sqrt(len);
+  for(int n = 0; n < 4; n++)
+    a[n] *= len;
+}
+
+OrientationFilter::OrientationFilter()
+: type(FILTER_NONE), minCutoff(1.0f), beta(2.0f), dCutoff(1.0f),
+  current(FILTER_NONE), primed(false), last(0), speed(0) {}
+
+void OrientationFilter::reset() {
+  primed = false;
+  speed = 0;
+}
+
+void OrientationFilter::apply(InputEvent & e) {
+  if(e.type == EVENT_UNPAIR)
+    reset();
+  if(e.type != EVENT_ORIENTATION)
+    return;
+
+  int t = type;
+  if(t != current) {
+    current = t;
+    reset();
+  }
+  if(t == FILTER_NONE)
+    return;
+
+  if(!primed || e.timestamp <= last || e.timestamp - last > FILTER_GAP_US) {
+    for(int n = 0; n < 4; n++)
+      raw[n] = out[n] = e.quat[n];
+    last = e.timestamp;
+    primed = true;
+    return;
+  }
+
+  float dt = (e.timestamp - last) / 1000000.0f;
+  last = e.timestamp;
+
+  float cutoff = minCutoff;
+
+  //fast turns open the filter up so strokes don't trail behind the arm
+  if(t == FILTER_EURO) {
+    float rate = angle(raw, e.quat) / dt;
+    speed += alpha(dCutoff, dt) * (rate - speed);
+    cutoff += beta * speed;
+  }
+
+  for(int n = 0; n < 4; n++)
+    raw[n] = e.quat[n];
+
+  slerp(out, e.quat, alpha(cutoff, dt));
+
+  for(int n = 0; n < 4; n++)
+    e.quat[n] = out[n];
+}
@@ -0,0 +1,53 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Filter.h
+ Description:   Orientation smoothing run on the input thread before events
+                are queued, tunable from the drawing loop while running.
+ *****************************************************************************/
+
+
+#include <atomic>
+#include <string>
+#include "Input.h"
+
+#ifndef FILTER_H
+#define FILTER_H
+
+const int FILTER_NONE = 0;
+const int FILTER_EURO = 1;    //One Euro, cutoff rises with angular speed
+const int FILTER_SLERP = 2;   //fixed cutoff exponential smoothing
+const int FILTER_TYPES = 3;
+
+extern const char * FILTER_NAMES[FILTER_TYPES];
+
+//FILTER_* by name, -1 if unknown
+int filterType(const std::string & name);
+
+class OrientationFilter{
+  public:
+    OrientationFilter();
+
+    //input thread, smooths orientation events in place
+    void apply(InputEvent & e);
+
+    //drawing loop side, picked up from the next sample on
+    std::atomic<int> type;
+    std::atomic<float> minCutoff;   //Hz, the cutoff while holding still
+    std::atomic<float> beta;        //Hz of extra cutoff per rad/s of turning
+    std::atomic<float> dCutoff;     //Hz, smoothing of the speed estimate
+
+  private:
+    void reset();
+
+    int current;
+    bool primed;
+    uint64_t last;
+
+    float raw[4];
+    float out[4];
+    float speed;
+};
+
+#endif /* FILTER_H */
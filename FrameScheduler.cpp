@@ -0,0 +1,122 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     FrameScheduler.cpp
+ Description:   Paces the frame loop to the display's refresh, a fixed rate
+                or not at all, and counts frames that missed their deadline.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "FrameScheduler.h"
+#include "Tracer.h"
+#include "Log.h"
+
+#include <algorithm>
+
+const char * PACING_NAMES[PACING_MODES] = {"vsync", "fixed", "uncapped"};
+
+//the last stretch before a frame is due is spun out, a little longer than
+//SDL_Delay has lately overslept and never more than PACING_SPIN_MS
+const double PACING_SPIN_MS = 2;
+const double PACING_SPIN_MARGIN_MS = 0.25;
+const double PACING_OVERSLEEP_DECAY = 0.95;
+
+//frames to settle before checking that vsync blocks, then how many to
+//average over
+const unsigned int VSYNC_WARMUP = 10;
+const unsigned int VSYNC_CHECK = 60;
+
+//vsync that gives frames much faster than the refresh isn't happening
+const double VSYNC_MIN_PERIODS = 0.75;
+
+int pacingMode(const std::string & name) {
+  for(int n = 0; n < PACING_MODES; n++)
+    if(name == PACING_NAMES[n])
+      return n;
+  return -1;
+}
+
+FrameScheduler::FrameScheduler()
+: mode(PACING_UNCAPPED), rate(60), missed(0), period(0), next(0), last(0),
+  spin(0), oversleep(0), streak(0), checkStart(0) {}
+
+void FrameScheduler::start(int pacing, double fps) {
+  Uint64 freq = SDL_GetPerformanceFrequency();
+
+  mode = pacing;
+  rate = fps;
+  period = (Uint64) (freq / rate);
+  spin = (Uint64) (freq * PACING_SPIN_MS / 1000);
+  oversleep = spin;
+  next = 0;
+  last = 0;
+  missed = 0;
+  streak = 0;
+  checkStart = 0;
+}
+
+void FrameScheduler::wait() {
+  if(mode != PACING_FIXED)
+    return;
+
+  Uint64 now = SDL_GetPerformanceCounter();
+
+  //more than a frame behind, start a new cadence rather than rushing
+  //frames out to catch up
+  if(next == 0 || now > next + period) {
+    next = now + period;
+    return;
+  }
+
+  if(next > now + spin) {
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 wake = next - spin;
+    SDL_Delay((Uint32) ((wake - now) * 1000 / freq));
+
+    Uint64 woke = SDL_GetPerformanceCounter();
+    oversleep = std::max(woke > wake ? (double) (woke - wake) : 0.0,
+        oversleep * PACING_OVERSLEEP_DECAY);
+    spin = (Uint64) std::min(oversleep + freq * PACING_SPIN_MARGIN_MS / 1000,
+        freq * PACING_SPIN_MS / 1000);
+  }
+  while(SDL_GetPerformanceCounter() < next)
+    ;
+
+  next += period;
+}
+
+void FrameScheduler::presented() {
+  Uint64 now = SDL_GetPerformanceCounter();
+  streak++;
+
+  //a frame that took n refreshes to come out missed n - 1 deadlines
+  if(last != 0 && mode != PACING_UNCAPPED) {
+    int skipped = (int) ((now - last) / (double) period + 0.5) - 1;
+    if(skipped > 0) {
+      missed += skipped;
+      tracer.instant("missed_deadline", "refreshes", skipped);
+    }
+  }
+  last = now;
+
+  if(mode != PACING_VSYNC)
+    return;
+
+  //only over frames drawn back to back
+  if(streak == VSYNC_WARMUP) {
+    checkStart = now;
+  }
+  else if(streak == VSYNC_WARMUP + VSYNC_CHECK &&
+      now - checkStart < VSYNC_CHECK * period * VSYNC_MIN_PERIODS) {
+    logger.write(LOG_WARN, "Vsync isn't holding frames back, pacing to %g Hz instead", rate);
+    mode = PACING_FIXED;
+    next = 0;
+  }
+}
+
+void FrameScheduler::skipped() {
+  last = 0;
+  next = 0;
+  streak = 0;
+}
@@ -0,0 +1,61 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     FrameScheduler.h
+ Description:   Paces the frame loop to the display's refresh, a fixed rate
+                or not at all, and counts frames that missed their deadline.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <string>
+
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+const int PACING_VSYNC = 0;     //present blocks until the display refreshes
+const int PACING_FIXED = 1;     //sleep then spin to a steady rate
+const int PACING_UNCAPPED = 2;  //as fast as the loop goes
+const int PACING_MODES = 3;
+
+extern const char * PACING_NAMES[PACING_MODES];
+
+//PACING_* by name, -1 if unknown
+int pacingMode(const std::string & name);
+
+class FrameScheduler{
+  public:
+    FrameScheduler();
+
+    //fps is the display's refresh for vsync
+    void start(int pacing, double fps);
+
+    //main thread, before each frame. Only fixed pacing waits here
+    void wait();
+
+    //right after present, counts the refreshes skipped since the last one.
+    //Falls back to fixed pacing when vsync turns out not to block
+    void presented();
+
+    //a frame deliberately not drawn, the wait until the next one isn't
+    //missed deadlines
+    void skipped();
+
+    int mode;
+    double rate;
+
+    unsigned int missed;    //deadlines passed without a new frame
+
+  private:
+    Uint64 period;
+    Uint64 next;            //when the next fixed frame is due
+    Uint64 last;            //previous present
+    Uint64 spin;            //how close to the deadline sleeping stops
+    double oversleep;       //worst SDL_Delay overshoot lately, decaying
+
+    unsigned int streak;    //presents since the last skipped frame
+    Uint64 checkStart;      //first present vsync is checked from
+};
+
+#endif /* FRAMESCHEDULER_H */
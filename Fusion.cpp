@@ -0,0 +1,148 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Fusion.cpp
+ Description:   Mahony style sensor fusion of the raw gyroscope and
+                accelerometer, pulled toward the armband's own orientation.
+ *****************************************************************************/
+
+#include "Fusion.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+//a gap this long means the stream restarted, don't integrate across it
+const uint64_t FUSION_GAP_US = 200000;
+
+const float DEG_TO_RAD = (float) (M_PI / 180);
+
+Fusion::Fusion()
+: enabled(false), kp(5), ki(0.1f), ka(0.5f) {
+  reset();
+}
+
+void Fusion::reset() {
+  anchored = false;
+  spinning = false;
+  lastGyro = 0;
+  pending = false;
+  anchorTime = 0;
+  haveGravity = false;
+
+  q[0] = 1;
+  for(int n = 0; n < 3; n++) {
+    q[n + 1] = 0;
+    error[n] = 0;
+    bias[n] = 0;
+    gravity[n] = 0;
+  }
+}
+
+//rotation from the estimate to the armband, as a small angle vector in the
+//band's frame: 2 * vector part of conj(q) * anchor
+void Fusion::correct() {
+  const float * a = anchor;
+  float w = q[0] * a[0] + q[1] * a[1] + q[2] * a[2] + q[3] * a[3];
+  float sign = w < 0 ? -2.0f : 2.0f;
+  error[0] = sign * (q[0] * a[1] - q[1] * a[0] - q[2] * a[3] + q[3] * a[2]);
+  error[1] = sign * (q[0] * a[2] + q[1] * a[3] - q[2] * a[0] - q[3] * a[1]);
+  error[2] = sign * (q[0] * a[3] - q[1] * a[2] + q[2] * a[1] - q[3] * a[0]);
+  pending = false;
+}
+
+void Fusion::apply(InputEvent & e) {
+  if(!enabled)
+    return;
+
+  switch(e.type) {
+    case EVENT_UNPAIR:
+      reset();
+      break;
+
+    case EVENT_ORIENTATION:
+      //without a live gyroscope the armband's orientation passes through
+      if(!anchored || !spinning || e.timestamp > lastGyro + FUSION_GAP_US) {
+        for(int n = 0; n < 4; n++)
+          q[n] = e.quat[n];
+        anchored = true;
+        spinning = false;
+        break;
+      }
+
+      //compare once the estimate has caught up to the same moment, the
+      //gyroscope sample for it can come either side
+      for(int n = 0; n < 4; n++)
+        anchor[n] = e.quat[n];
+      anchorTime = e.timestamp;
+      pending = true;
+      if(lastGyro >= anchorTime)
+        correct();
+
+      for(int n = 0; n < 4; n++)
+        e.quat[n] = q[n];
+      break;
+
+    case EVENT_ACCELEROMETER: {
+      float len = std::sqrt(e.quat[1] * e.quat[1] + e.quat[2] * e.quat[2] + e.quat[3] * e.quat[3]);
+      haveGravity = len > 0;
+      for(int n = 0; n < 3; n++)
+        gravity[n] = haveGravity ? e.quat[n + 1] / len : 0;
+      break;
+    }
+
+    case EVENT_GYROSCOPE: {
+      if(!anchored)
+        break;
+
+      bool restart = !spinning || e.timestamp <= lastGyro || e.timestamp - lastGyro > FUSION_GAP_US;
+      float dt = restart ? 0 : (e.timestamp - lastGyro) / 1000000.0f;
+      lastGyro = e.timestamp;
+      spinning = true;
+
+      float w = q[0], x = q[1], y = q[2], z = q[3];
+
+      //total correction, the pull to the armband plus gravity: the measured
+      //up direction crossed with the one the estimate predicts
+      float c[3];
+      for(int n = 0; n < 3; n++)
+        c[n] = kp * error[n];
+
+      if(haveGravity) {
+        float vx = 2 * (x * z - w * y);
+        float vy = 2 * (y * z + w * x);
+        float vz = 1 - 2 * (x * x + y * y);
+        c[0] += ka * (gravity[1] * vz - gravity[2] * vy);
+        c[1] += ka * (gravity[2] * vx - gravity[0] * vz);
+        c[2] += ka * (gravity[0] * vy - gravity[1] * vx);
+      }
+
+      float k = ki;
+      for(int n = 0; n < 3; n++)
+        bias[n] += k * error[n] * dt;
+
+      float gx = e.quat[1] * DEG_TO_RAD + c[0] + bias[0];
+      float gy = e.quat[2] * DEG_TO_RAD + c[1] + bias[1];
+      float gz = e.quat[3] * DEG_TO_RAD + c[2] + bias[2];
+
+      //q += q * (0, g) * dt / 2
+      float h = dt / 2;
+      q[0] = w + h * (-x * gx - y * gy - z * gz);
+      q[1] = x + h * (w * gx + y * gz - z * gy);
+      q[2] = y + h * (w * gy - x * gz + z * gx);
+      q[3] = z + h * (w * gz + x * gy - y * gx);
+
+      float len = 1 / std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+      for(int n = 0; n < 4; n++)
+        q[n] *= len;
+
+      if(pending && lastGyro >= anchorTime)
+        correct();
+
+      e.type = EVENT_ORIENTATION;
+      for(int n = 0; n < 4; n++)
+        e.quat[n] = q[n];
+      break;
+    }
+  }
+}
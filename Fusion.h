@@ -0,0 +1,49 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Fusion.h
+ Description:   Mahony style sensor fusion of the raw gyroscope and
+                accelerometer, pulled toward the armband's own orientation.
+ *****************************************************************************/
+
+
+#include <atomic>
+#include "Input.h"
+
+#ifndef FUSION_H
+#define FUSION_H
+
+class Fusion{
+  public:
+    Fusion();
+
+    //input thread, in event order. Gyroscope samples become orientation
+    //events carrying the fused estimate, orientation events are replaced
+    //by it too once the gyroscope is running
+    void apply(InputEvent & e);
+
+    std::atomic<bool> enabled;
+    std::atomic<float> kp;  //rad/s of correction per rad off the armband's orientation
+    std::atomic<float> ki;  //rate at which that error is learned as gyro bias
+    std::atomic<float> ka;  //rad/s of tilt correction per unit accelerometer error
+
+  private:
+    void reset();
+    void correct();
+
+    bool anchored;
+    bool spinning;
+    uint64_t lastGyro;
+
+    float q[4];         //fused orientation, w, x, y, z
+    float anchor[4];    //last armband orientation
+    uint64_t anchorTime;
+    bool pending;       //anchor not yet compared with the estimate
+    float error[3];     //body frame rotation to the last armband orientation
+    float bias[3];      //integral term, rad/s
+    float gravity[3];   //last accelerometer reading, unit length
+    bool haveGravity;
+};
+
+#endif /* FUSION_H */
@@ -0,0 +1,212 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Gesture.cpp
+ Description:   Small trainable pose classifier over EMG window features, run
+                on the input thread in place of the armband's own poses.
+ *****************************************************************************/
+
+#include "Gesture.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+//samples in a row the classifier must agree on before a pose is sent, 15 ms
+const int GESTURE_HOLD = 3;
+
+//a gap this long means the EMG stream restarted
+const uint64_t GESTURE_GAP_US = 100000;
+
+//keeps a feature that never varied in training from dominating
+const float GESTURE_MIN_VARIANCE = 1e-4f;
+
+const char GESTURE_MAGIC[] = "myodraw-gestures";
+const int GESTURE_VERSION = 1;
+
+GestureClassifier::GestureClassifier()
+: trained(false) {
+  memset(sums, 0, sizeof(sums));
+  memset(squares, 0, sizeof(squares));
+  memset(seen, 0, sizeof(seen));
+  memset(mean, 0, sizeof(mean));
+  for(int p = 0; p < POSE_TYPES; p++)
+    known[p] = false;
+  for(int f = 0; f < EMG_FEATURES; f++)
+    weight[f] = 1;
+}
+
+//amplitudes spread over orders of magnitude, their logs are closer to normal
+void GestureClassifier::transform(const float features[EMG_FEATURES], float out[EMG_FEATURES]) {
+  for(int f = 0; f < 2 * EMG_CHANNELS; f++)
+    out[f] = std::log(1 + features[f]);
+  for(int f = 2 * EMG_CHANNELS; f < EMG_FEATURES; f++)
+    out[f] = features[f];
+}
+
+void GestureClassifier::learn(const float features[EMG_FEATURES], int pose) {
+  if(pose < 0 || pose >= POSE_TYPES)
+    return;
+
+  float x[EMG_FEATURES];
+  transform(features, x);
+
+  for(int f = 0; f < EMG_FEATURES; f++) {
+    sums[pose][f] += x[f];
+    squares[pose][f] += x[f] * x[f];
+  }
+  seen[pose]++;
+}
+
+bool GestureClassifier::train() {
+  double total = 0;
+  int poses = 0;
+  for(int p = 0; p < POSE_TYPES; p++) {
+    known[p] = seen[p] > 0;
+    total += seen[p];
+    poses += known[p];
+  }
+
+  if(!known[POSE_OTHER] || poses < 2)
+    return false;
+
+  for(int f = 0; f < EMG_FEATURES; f++) {
+    double within = 0;
+    for(int p = 0; p < POSE_TYPES; p++) {
+      if(!known[p])
+        continue;
+      double m = sums[p][f] / seen[p];
+      mean[p][f] = (float) m;
+      within += squares[p][f] - seen[p] * m * m;
+    }
+
+    float variance = (float) (within / total);
+    weight[f] = 1 / (variance > GESTURE_MIN_VARIANCE ? variance : GESTURE_MIN_VARIANCE);
+  }
+
+  trained = true;
+  return true;
+}
+
+int GestureClassifier::classify(const float features[EMG_FEATURES]) {
+  float x[EMG_FEATURES];
+  transform(features, x);
+
+  int best = POSE_OTHER;
+  float bestScore = -1;
+
+  for(int p = 0; p < POSE_TYPES; p++) {
+    if(!known[p])
+      continue;
+
+    float score = 0;
+    for(int f = 0; f < EMG_FEATURES; f++) {
+      float d = x[f] - mean[p][f];
+      score += weight[f] * d * d;
+    }
+
+    if(bestScore < 0 || score < bestScore) {
+      best = p;
+      bestScore = score;
+    }
+  }
+
+  return best;
+}
+
+//plain text, one line per pose, whether it was trained then its mean, and
+//a line of weights
+bool GestureClassifier::save(const std::string & path) {
+  if(!trained)
+    return false;
+
+  FILE * f = fopen(path.c_str(), "w");
+  if(f == NULL)
+    return false;
+
+  fprintf(f, "%s %d %d %d\n", GESTURE_MAGIC, GESTURE_VERSION, POSE_TYPES, EMG_FEATURES);
+  for(int p = 0; p < POSE_TYPES; p++) {
+    fprintf(f, "%d ", known[p] ? 1 : 0);
+    for(int n = 0; n < EMG_FEATURES; n++)
+      fprintf(f, "%.9g ", mean[p][n]);
+    fprintf(f, "\n");
+  }
+  for(int n = 0; n < EMG_FEATURES; n++)
+    fprintf(f, "%.9g ", weight[n]);
+  fprintf(f, "\n");
+
+  return fclose(f) == 0;
+}
+
+bool GestureClassifier::load(const std::string & path) {
+  FILE * f = fopen(path.c_str(), "r");
+  if(f == NULL)
+    return false;
+
+  char magic[32];
+  int version = 0, poses = 0, features = 0;
+  bool good = fscanf(f, "%31s %d %d %d", magic, &version, &poses, &features) == 4 &&
+      strcmp(magic, GESTURE_MAGIC) == 0 && version == GESTURE_VERSION &&
+      poses == POSE_TYPES && features == EMG_FEATURES;
+
+  for(int p = 0; good && p < POSE_TYPES; p++) {
+    int flag = 0;
+    good = fscanf(f, "%d", &flag) == 1;
+    known[p] = flag != 0;
+    for(int n = 0; good && n < EMG_FEATURES; n++)
+      good = fscanf(f, "%f", &mean[p][n]) == 1;
+  }
+  for(int n = 0; good && n < EMG_FEATURES; n++)
+    good = fscanf(f, "%f", &weight[n]) == 1;
+
+  fclose(f);
+  trained = good && known[POSE_OTHER];
+  return trained;
+}
+
+Gestures::Gestures()
+: enabled(false), last(0), current(-1), candidate(-1), streak(0) {}
+
+bool Gestures::apply(const InputEvent & e, InputEvent & pose, bool & posed) {
+  posed = false;
+  if(!enabled || !classifier.trained)
+    return true;
+
+  if(e.type == EVENT_POSE)
+    return false;
+  if(e.type != EVENT_EMG)
+    return true;
+
+  if(e.timestamp - last > GESTURE_GAP_US) {
+    window.reset();
+    streak = 0;
+  }
+  last = e.timestamp;
+
+  window.add(e.emg);
+  if(!window.full())
+    return true;
+
+  window.features(features);
+  int next = classifier.classify(features);
+
+  if(next == candidate) {
+    streak++;
+  }
+  else {
+    candidate = next;
+    streak = 1;
+  }
+
+  if(streak < GESTURE_HOLD || candidate == current)
+    return true;
+
+  //the sample itself still goes on to pressure and the drawing loop
+  current = candidate;
+  pose = e;
+  pose.type = EVENT_POSE;
+  pose.value = current;
+  posed = true;
+  return true;
+}
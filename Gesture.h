@@ -0,0 +1,75 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Gesture.h
+ Description:   Small trainable pose classifier over EMG window features, run
+                on the input thread in place of the armband's own poses.
+ *****************************************************************************/
+
+
+#include <atomic>
+#include <string>
+#include "Input.h"
+#include "Emg.h"
+
+#ifndef GESTURE_H
+#define GESTURE_H
+
+//nearest class mean, each feature weighted by its pooled within class
+//variance. Trained from sessions the armband labelled with its own poses
+class GestureClassifier{
+  public:
+    GestureClassifier();
+
+    //one labelled window of features, pose is POSE_*
+    void learn(const float features[EMG_FEATURES], int pose);
+
+    //fit to everything learned so far, false unless rest and at least one
+    //other pose were seen
+    bool train();
+
+    //POSE_* closest to features, out of the poses seen in training
+    int classify(const float features[EMG_FEATURES]);
+
+    bool save(const std::string & path);
+    bool load(const std::string & path);
+
+    bool trained;
+
+  private:
+    static void transform(const float features[EMG_FEATURES], float out[EMG_FEATURES]);
+
+    double sums[POSE_TYPES][EMG_FEATURES];
+    double squares[POSE_TYPES][EMG_FEATURES];
+    double seen[POSE_TYPES];
+
+    bool known[POSE_TYPES];
+    float mean[POSE_TYPES][EMG_FEATURES];
+    float weight[EMG_FEATURES];   //inverse variance
+};
+
+class Gestures{
+  public:
+    Gestures();
+
+    //input thread, in event order. The armband's own pose events are
+    //dropped, false means e should be. When an EMG sample changes the
+    //classified pose, posed is set and pose is the event to send after it
+    bool apply(const InputEvent & e, InputEvent & pose, bool & posed);
+
+    std::atomic<bool> enabled;
+
+    //set before the input thread starts
+    GestureClassifier classifier;
+
+  private:
+    EmgWindow window;
+    float features[EMG_FEATURES];
+    uint64_t last;
+    int current;      //last pose sent
+    int candidate;    //pose the classifier has been seeing
+    int streak;       //samples in a row it has seen it
+};
+
+#endif /* GESTURE_H */
@@ -0,0 +1,69 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Input.cpp
+ Description:   Timestamped input events passed from the armband thread to
+                the drawing loop, and the state built up from them.
+ *****************************************************************************/
+
+#include "Input.h"
+
+//named after the DataCollector callback each event comes from
+const char * EVENT_NAMES[EVENT_TYPES] = {
+  "onOrientationData", "onPose", "onArmSync", "onArmUnsync", "onUnlock", "onLock", "onUnpair",
+  "onGyroscopeData", "onAccelerometerData", "onEmgData", "onPair"
+};
+
+InputState::InputState()
+: paired(false), onArm(false), isUnlocked(false), quat{1, 0, 0, 0}, centered(0), pressure(0),
+  currentPose(POSE_OTHER), timestamp(0) {}
+
+void InputState::apply(const InputEvent & e) {
+  timestamp = e.timestamp;
+
+  switch(e.type) {
+    case EVENT_ORIENTATION:
+      for(int n = 0; n < 4; n++)
+        quat[n] = e.quat[n];
+      break;
+    case EVENT_POSE:
+      //double tap recenters on wherever the arm points right now
+      if(e.value == POSE_TAP && currentPose != POSE_FIST)
+        centered++;
+      currentPose = e.value;
+      break;
+    case EVENT_ARM_SYNC:
+      onArm = true;
+      break;
+    case EVENT_ARM_UNSYNC:
+      onArm = false;
+      break;
+    case EVENT_UNLOCK:
+      isUnlocked = true;
+      break;
+    case EVENT_LOCK:
+      isUnlocked = false;
+      break;
+    case EVENT_EMG:
+      pressure = e.value / (float) PRESSURE_STEPS;
+      break;
+    case EVENT_PAIR:
+      paired = true;
+      break;
+    case EVENT_UNPAIR:
+      paired = false;
+      quat[0] = 1;
+      quat[1] = 0;
+      quat[2] = 0;
+      quat[3] = 0;
+      onArm = false;
+      isUnlocked = false;
+      pressure = 0;
+      break;
+  }
+}
+
+int InputState::getPose() {
+  return currentPose;
+}
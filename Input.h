@@ -0,0 +1,85 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Input.h
+ Description:   Timestamped input events passed from the armband thread to
+                the drawing loop, and the state built up from them.
+ *****************************************************************************/
+
+
+#include <stdint.h>
+#include "RingBuffer.h"
+
+#ifndef INPUT_H
+#define INPUT_H
+
+const int POSE_FIST = 0;
+const int POSE_TAP = 1;
+const int POSE_SPREAD = 2;
+const int POSE_OTHER = 3;
+const int POSE_TYPES = 4;
+
+const int EVENT_ORIENTATION = 0;
+const int EVENT_POSE = 1;
+const int EVENT_ARM_SYNC = 2;
+const int EVENT_ARM_UNSYNC = 3;
+const int EVENT_UNLOCK = 4;
+const int EVENT_LOCK = 5;
+const int EVENT_UNPAIR = 6;
+const int EVENT_GYROSCOPE = 7;
+const int EVENT_ACCELEROMETER = 8;
+const int EVENT_EMG = 9;
+const int EVENT_PAIR = 10;
+const int EVENT_TYPES = 11;
+
+const int EMG_CHANNELS = 8;
+
+//full grip in EVENT_EMG's value
+const int PRESSURE_STEPS = 1000;
+
+extern const char * EVENT_NAMES[EVENT_TYPES];
+
+struct InputEvent {
+  uint64_t timestamp; //microseconds, as reported by the armband
+  int type;           //EVENT_*
+  int value;          //POSE_* for EVENT_POSE, arm for EVENT_ARM_SYNC, grip
+                      //pressure 0..PRESSURE_STEPS for EVENT_EMG once the
+                      //input thread has measured it
+  float quat[4];      //w, x, y, z for EVENT_ORIENTATION, 0, x, y, z in the
+                      //armband's frame for EVENT_GYROSCOPE (deg/s) and
+                      //EVENT_ACCELEROMETER (g)
+  int8_t emg[EMG_CHANNELS]; //raw muscle activity for EVENT_EMG, 200 Hz
+};
+
+//about 20 seconds of the armband streaming everything, 350 events/s of
+//orientation, gyroscope and accelerometer at 50 Hz and EMG at 200 Hz
+typedef RingBuffer<InputEvent, 8192> InputQueue;
+
+//what the drawing loop knows about the armband, rebuilt from events in order
+class InputState{
+  public:
+    InputState();
+
+    void apply(const InputEvent & e);
+
+    int getPose();
+
+    bool paired;
+    bool onArm;
+    bool isUnlocked;
+
+    //latest orientation, w, x, y, z
+    float quat[4];
+
+    //bumped by every recenter, the sample that bumps it is the new center
+    unsigned int centered;
+
+    //how hard the fist is held, 0 to 1, from the latest EMG
+    float pressure;
+
+    int currentPose;
+    uint64_t timestamp;
+};
+
+#endif /* INPUT_H */
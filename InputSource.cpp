@@ -0,0 +1,210 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     InputSource.cpp
+ Description:   Base for anything that feeds armband events to the drawing
+                loop. Each source produces on its own thread into a queue.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "InputSource.h"
+#include "Tracer.h"
+
+#include <cstdio>
+#include <iostream>
+
+InputSource::InputSource()
+: dropped(0), running(false), done(false), wakeType(0), handle(NULL), recorder(NULL), fusion(NULL), filter(NULL), gestures(NULL),
+  pressure(NULL), paced(false),
+  paceStamp(0), paceCounter(0) {}
+
+InputSource::~InputSource() {
+  //derived sources must stop() in their own destructor, run() is gone by now
+}
+
+int InputSource::start() {
+  running = true;
+  handle = SDL_CreateThread(thread, "input", this);
+
+  if(handle == NULL) {
+    printf("Input thread could not be created! SDL Error: %s\n", SDL_GetError());
+    running = false;
+    return -1;
+  }
+
+  return 0;
+}
+
+void InputSource::stop() {
+  if(handle == NULL)
+    return;
+
+  running = false;
+  SDL_WaitThread(handle, NULL);
+  handle = NULL;
+
+  if(dropped > 0)
+    std::cout << "Dropped " << dropped << " input events" << std::endl;
+}
+
+bool InputSource::poll(InputEvent & e) {
+  return queue.pop(e);
+}
+
+unsigned int InputSource::pending() {
+  return queue.size();
+}
+
+bool InputSource::wakeOnPush(Uint32 type) {
+  wakeType = type;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if(queue.size() == 0)
+    return true;
+
+  wakeType = 0;
+  return false;
+}
+
+//source thread, after a push. The fence pairs with wakeOnPush() storing
+//the type before it looks at the queue, so one of the two sees the other
+void InputSource::wake() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if(wakeType.load(std::memory_order_relaxed) == 0)
+    return;
+
+  Uint32 type = wakeType.exchange(0);
+  if(type == 0)
+    return;
+
+  SDL_Event e;
+  SDL_zero(e);
+  e.type = type;
+  SDL_PushEvent(&e);
+}
+
+bool InputSource::finished() {
+  return done && queue.size() == 0;
+}
+
+void InputSource::record(Recorder * recorder) {
+  this->recorder = recorder;
+}
+
+void InputSource::fuse(Fusion * fusion) {
+  this->fusion = fusion;
+}
+
+void InputSource::smooth(OrientationFilter * filter) {
+  this->filter = filter;
+}
+
+void InputSource::classify(Gestures * gestures) {
+  this->gestures = gestures;
+}
+
+void InputSource::measure(Pressure * pressure) {
+  this->pressure = pressure;
+}
+
+//timeline marker with the armband's own timestamp
+static void trace(const InputEvent & e) {
+  if(e.type >= 0 && e.type < EVENT_TYPES)
+    tracer.instant(EVENT_NAMES[e.type], "myo_us", (double) e.timestamp);
+}
+
+//recordings keep the raw events so replays can try other filters. Returns
+//how many events to queue, none when a stage dropped e and two when the
+//classifier's pose changed after it
+int InputSource::prepare(const InputEvent & e, InputEvent out[2]) {
+  trace(e);
+  if(recorder != NULL)
+    recorder->write(e);
+
+  int count = 1;
+  out[0] = e;
+  if(gestures != NULL) {
+    bool posed;
+    if(!gestures->apply(e, out[1], posed))
+      return 0;
+    count += posed;
+  }
+
+  for(int n = 0; n < count; n++) {
+    if(pressure != NULL)
+      pressure->apply(out[n]);
+    if(fusion != NULL)
+      fusion->apply(out[n]);
+    if(filter != NULL)
+      filter->apply(out[n]);
+  }
+  return count;
+}
+
+bool InputSource::push(const InputEvent & e) {
+  InputEvent f[2];
+  int count = prepare(e, f);
+
+  bool pushed = true;
+  for(int n = 0; n < count; n++) {
+    if(!queue.push(f[n])) {
+      dropped++;
+      pushed = false;
+    }
+  }
+  if(count > 0)
+    wake();
+  return pushed;
+}
+
+bool InputSource::pushWait(const InputEvent & e) {
+  InputEvent f[2];
+  int count = prepare(e, f);
+  if(count == 0)
+    return running;
+
+  for(int n = 0; n < count; n++) {
+    while(!queue.push(f[n])) {
+      if(!running)
+        return false;
+      SDL_Delay(1);
+    }
+  }
+  wake();
+  return true;
+}
+
+void InputSource::pace(uint64_t timestamp, float speed) {
+  Uint64 now = SDL_GetPerformanceCounter();
+
+  if(!paced || timestamp < paceStamp) {
+    paced = true;
+    paceStamp = timestamp;
+    paceCounter = now;
+    return;
+  }
+
+  if(speed <= 0)
+    return;
+
+  Uint64 freq = SDL_GetPerformanceFrequency();
+  Uint64 due = paceCounter + (Uint64) ((timestamp - paceStamp) / speed * freq / 1000000.0);
+
+  //sleep off whole milliseconds, spin the remainder
+  while(running && now < due) {
+    Uint64 ms = (due - now) * 1000 / freq;
+    if(ms > 1)
+      SDL_Delay((Uint32) (ms - 1));
+    else
+      SDL_Delay(0);
+    now = SDL_GetPerformanceCounter();
+  }
+}
+
+int SDLCALL InputSource::thread(void * data) {
+  InputSource * source = (InputSource *) data;
+  tracer.nameThread("input");
+  source->run();
+  source->done = true;
+  return 0;
+}
@@ -0,0 +1,93 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     InputSource.h
+ Description:   Base for anything that feeds armband events to the drawing
+                loop. Each source produces on its own thread into a queue.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include "Input.h"
+#include "Recording.h"
+#include "Filter.h"
+#include "Fusion.h"
+#include "Gesture.h"
+#include "Pressure.h"
+
+#ifndef INPUTSOURCE_H
+#define INPUTSOURCE_H
+
+class InputSource{
+  public:
+    InputSource();
+    virtual ~InputSource();
+
+    int start();
+    void stop();
+
+    //drawing loop side, false once the queue is empty
+    bool poll(InputEvent & e);
+    unsigned int pending();
+
+    //true once a finite source has queued its last event
+    bool finished();
+
+    //drawing loop side, the next event queued pushes an SDL event of type
+    //so SDL_WaitEvent can sleep on both. False, and nothing armed, when
+    //events are already waiting
+    bool wakeOnPush(Uint32 type);
+
+    //log every event produced from here on, set before start()
+    void record(Recorder * recorder);
+
+    //fuse the raw IMU streams and smooth orientation on the source thread,
+    //set before start()
+    void fuse(Fusion * fusion);
+    void smooth(OrientationFilter * filter);
+
+    //classify poses and measure grip pressure from EMG on the source
+    //thread, set before start()
+    void classify(Gestures * gestures);
+    void measure(Pressure * pressure);
+
+    //producer side, called from the source thread. Live sources drop
+    //events when the queue is full, recorded ones wait for room instead
+    bool push(const InputEvent & e);
+    bool pushWait(const InputEvent & e);
+
+    std::atomic<unsigned int> dropped;
+
+  protected:
+    //source thread body, should return soon after running turns false
+    virtual void run() = 0;
+
+    //sleep until an event stamped timestamp is due, speed 0 means never wait
+    void pace(uint64_t timestamp, float speed);
+
+    std::atomic<bool> running;
+    std::atomic<bool> done;
+
+  private:
+    static int SDLCALL thread(void * data);
+
+    int prepare(const InputEvent & e, InputEvent out[2]);
+    void wake();
+
+    InputQueue queue;
+    std::atomic<Uint32> wakeType;   //0 while the drawing loop is awake
+    SDL_Thread * handle;
+    Recorder * recorder;
+    Fusion * fusion;
+    OrientationFilter * filter;
+    Gestures * gestures;
+    Pressure * pressure;
+
+    bool paced;
+    uint64_t paceStamp;
+    Uint64 paceCounter;
+};
+
+#endif /* INPUTSOURCE_H */
@@ -0,0 +1,149 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     LatencyProbe.cpp
+ Description:   Measures input to photon latency by injecting orientation
+                steps and timing the frame where the cursor moves.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "LatencyProbe.h"
+
+#include <cstdio>
+#include <cmath>
+
+//armband rate between steps, and the time between steps
+const unsigned int PROBE_RATE = 50;
+const unsigned int PROBE_STEP_MS = 200;
+
+//sideways jump, radians, big enough to move the cursor well clear of itself
+const float PROBE_YAW = 0.1f;
+
+LatencyProbe::LatencyProbe()
+: haveChecksum(false), lastChecksum(0), toMillis(0) {}
+
+SDL_Rect LatencyProbe::band(int width, int height) {
+  SDL_Rect r = {0, height / 2 - 24, width, 48};
+  return r;
+}
+
+void LatencyProbe::injected(uint64_t timestamp) {
+  ProbeTag tag = {timestamp, SDL_GetPerformanceCounter(), 0, false};
+  tags.push(tag);
+}
+
+void LatencyProbe::drained(const InputEvent & e, unsigned int frame) {
+  ProbeTag tag;
+  while(tags.pop(tag)) {
+    pending.push_back(tag);
+    unseen.push_back(tag);
+  }
+
+  for(unsigned int n = 0; n < pending.size(); n++)
+    if(pending[n].timestamp == e.timestamp && pending[n].frame == 0)
+      pending[n].frame = frame;
+}
+
+void LatencyProbe::presented(unsigned int frame, bool checked, Uint32 checksum) {
+  Uint64 now = SDL_GetPerformanceCounter();
+  if(toMillis == 0)
+    toMillis = 1000.0 / SDL_GetPerformanceFrequency();
+
+  //every step drawn this frame is now on its way to the screen
+  while(!pending.empty() && pending.front().frame != 0 && pending.front().frame <= frame) {
+    present.add((now - pending.front().injected) * toMillis);
+    pending.pop_front();
+  }
+
+  if(!checked)
+    return;
+
+  //the screen only changes when the cursor moves, so the first changed frame
+  //after a step is the one that shows it
+  bool changed = haveChecksum && checksum != lastChecksum;
+  haveChecksum = true;
+  lastChecksum = checksum;
+
+  if(changed && !unseen.empty()) {
+    photon.add((now - unseen.front().injected) * toMillis);
+    unseen.pop_front();
+  }
+}
+
+void LatencyProbe::report() {
+  printf("Latency probe, milliseconds:\n");
+  printf("%-16s %6s %8s %8s %8s %8s %8s\n", "", "steps", "mean", "p50", "p95", "p99", "max");
+
+  const Histogram * h[2] = {&present, &photon};
+  const char * names[2] = {"input->present", "input->pixels"};
+
+  for(int n = 0; n < 2; n++) {
+    if(h[n]->count == 0)
+      continue;
+    printf("%-16s %6u %8.2f %8.2f %8.2f %8.2f %8.2f\n", names[n], h[n]->count, h[n]->mean(),
+        h[n]->percentile(50), h[n]->percentile(95), h[n]->percentile(99), h[n]->max);
+  }
+
+  if(unseen.size() > 0)
+    printf("%u steps never showed up on screen\n", (unsigned int) unseen.size());
+}
+
+ProbeSource::ProbeSource(LatencyProbe & probe, unsigned int steps)
+: probe(probe), steps(steps) {}
+
+ProbeSource::~ProbeSource() {
+  stop();
+}
+
+void ProbeSource::orientation(uint64_t timestamp, float yaw, bool step) {
+  InputEvent e = {timestamp, EVENT_ORIENTATION, 0,
+    {std::cos(yaw / 2), 0, 0, std::sin(yaw / 2)}};
+
+  if(step)
+    probe.injected(timestamp);
+  push(e);
+}
+
+void ProbeSource::run() {
+  InputEvent sync = {0, EVENT_ARM_SYNC, 0, {1, 0, 0, 0}};
+  InputEvent tap = {0, EVENT_POSE, POSE_TAP, {1, 0, 0, 0}};
+  InputEvent rest = {0, EVENT_POSE, POSE_OTHER, {1, 0, 0, 0}};
+
+  //center on yaw 0, then hold still between steps
+  push(sync);
+  orientation(0, 0, false);
+  push(tap);
+  push(rest);
+
+  Uint64 freq = SDL_GetPerformanceFrequency();
+  Uint64 origin = SDL_GetPerformanceCounter();
+  unsigned int seed = 1;
+  float yaw = 0;
+
+  //the first step waits for the display to settle
+  unsigned int next = 1000;
+
+  for(unsigned int n = 1; running && steps > 0; n++) {
+    unsigned int due = n * 1000 / PROBE_RATE;
+    Uint64 wake = origin + (Uint64) due * freq / 1000;
+
+    while(running && SDL_GetPerformanceCounter() < wake)
+      SDL_Delay(1);
+
+    bool step = due >= next;
+    if(step) {
+      yaw = yaw > 0 ? -PROBE_YAW : PROBE_YAW;
+      steps--;
+
+      //jitter the step time so it doesn't phase lock with the frame loop
+      seed = seed * 1103515245 + 12345;
+      next = due + PROBE_STEP_MS + (seed >> 16) % 33;
+    }
+
+    orientation(due * 1000ULL, yaw, step);
+  }
+
+  //let the last step reach the screen before the run ends
+  SDL_Delay(PROBE_STEP_MS);
+}
@@ -0,0 +1,73 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     LatencyProbe.h
+ Description:   Measures input to photon latency by injecting orientation
+                steps and timing the frame where the cursor moves.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <deque>
+#include "InputSource.h"
+#include "Profiler.h"
+
+#ifndef LATENCYPROBE_H
+#define LATENCYPROBE_H
+
+struct ProbeTag {
+  uint64_t timestamp;   //armband timestamp of the step sample
+  Uint64 injected;      //performance counter when it was queued
+  unsigned int frame;   //frame that drained it, 0 until then
+  bool presented;
+};
+
+class LatencyProbe{
+  public:
+    LatencyProbe();
+
+    //input thread, a step sample was just queued
+    void injected(uint64_t timestamp);
+
+    //main thread, in loop order
+    void drained(const InputEvent & e, unsigned int frame);
+    void presented(unsigned int frame, bool checked, Uint32 checksum);
+
+    void report();
+
+    //rows around the cursor's resting height that the steps move it along
+    static SDL_Rect band(int width, int height);
+
+    //input queued -> present returned for the frame that drew it
+    Histogram present;
+    //input queued -> first frame whose pixels actually changed
+    Histogram photon;
+
+  private:
+    RingBuffer<ProbeTag, 64> tags;
+    std::deque<ProbeTag> pending;
+    std::deque<ProbeTag> unseen;
+
+    bool haveChecksum;
+    Uint32 lastChecksum;
+    double toMillis;
+};
+
+//stand-in armband that holds still and jumps the cursor sideways now and then
+class ProbeSource : public InputSource {
+  public:
+    ProbeSource(LatencyProbe & probe, unsigned int steps);
+    ~ProbeSource();
+
+  protected:
+    void run();
+
+  private:
+    void orientation(uint64_t timestamp, float yaw, bool step);
+
+    LatencyProbe & probe;
+    unsigned int steps;
+};
+
+#endif /* LATENCYPROBE_H */
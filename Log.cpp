@@ -0,0 +1,139 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Log.cpp
+ Description:   Console logging that never blocks the caller. Each thread
+                queues into its own lock free buffer, a background thread
+                formats and writes them out.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "Log.h"
+
+#include <cstdio>
+
+//how long queued messages may wait before the flusher writes them
+const Uint32 LOG_FLUSH_MS = 20;
+
+const char * LOG_LEVEL_NAMES[LOG_LEVELS] = {"debug", "info", "warn", "error"};
+
+Logger logger;
+
+//buffer of the calling thread, set on its first message
+static thread_local LogBuffer * threadBuffer = NULL;
+
+int logLevel(const std::string & name) {
+  for(int n = 0; n < LOG_LEVELS; n++)
+    if(name == LOG_LEVEL_NAMES[n])
+      return n;
+  return -1;
+}
+
+Logger::Logger()
+: level(LOG_INFO), dropped(0), file(NULL), running(false), handle(NULL), wake(NULL),
+  lock(SDL_CreateMutex()) {}
+
+Logger::~Logger() {
+  stop();
+  for(unsigned int n = 0; n < buffers.size(); n++)
+    deleteAligned(buffers[n]);
+  SDL_DestroyMutex(lock);
+}
+
+int Logger::start() {
+  if(handle != NULL)
+    return 0;
+
+  wake = SDL_CreateSemaphore(0);
+  running = true;
+  handle = SDL_CreateThread(thread, "log", this);
+  if(handle == NULL) {
+    running = false;
+    printf("Log thread failed! SDL_Error: %s\n", SDL_GetError());
+    return -1;
+  }
+  return 0;
+}
+
+void Logger::stop() {
+  if(handle != NULL) {
+    running = false;
+    SDL_SemPost(wake);
+    SDL_WaitThread(handle, NULL);
+    handle = NULL;
+    SDL_DestroySemaphore(wake);
+    wake = NULL;
+  }
+
+  //anything logged after the flusher stopped still gets out
+  flush();
+
+  if(dropped > 0) {
+    printf("Log dropped %u messages\n", dropped.load());
+    dropped = 0;
+  }
+}
+
+void Logger::redirect(FILE * to) {
+  file = to;
+}
+
+LogBuffer * Logger::current() {
+  if(threadBuffer != NULL)
+    return threadBuffer;
+
+  //first message on this thread, register a buffer for it
+  LogBuffer * b = newAligned<LogBuffer>();
+
+  SDL_LockMutex(lock);
+  buffers.push_back(b);
+  SDL_UnlockMutex(lock);
+
+  threadBuffer = b;
+  return b;
+}
+
+void Logger::record(int at, const char * format, double a, double b, double c) {
+  LogEntry e = {format, {a, b, c}, at};
+
+  //a full buffer loses the message rather than stalling the thread
+  if(!current()->push(e))
+    dropped++;
+}
+
+//flusher thread, or whoever calls stop(). Messages come out in order per
+//thread, threads take turns
+void Logger::flush() {
+  SDL_LockMutex(lock);
+  std::vector<LogBuffer *> all = buffers;
+  SDL_UnlockMutex(lock);
+
+  bool out = false, err = false;
+
+  for(unsigned int n = 0; n < all.size(); n++) {
+    LogEntry e;
+    while(all[n]->pop(e)) {
+      FILE * f = file != NULL ? file : e.level >= LOG_WARN ? stderr : stdout;
+      fprintf(f, e.format, e.args[0], e.args[1], e.args[2]);
+      fputc('\n', f);
+      out |= f != stderr;
+      err |= f == stderr;
+    }
+  }
+
+  if(out)
+    fflush(file != NULL ? file : stdout);
+  if(err)
+    fflush(stderr);
+}
+
+int SDLCALL Logger::thread(void * data) {
+  Logger * self = (Logger *) data;
+
+  while(self->running) {
+    SDL_SemWaitTimeout(self->wake, LOG_FLUSH_MS);
+    self->flush();
+  }
+  return 0;
+}
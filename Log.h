@@ -0,0 +1,91 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Log.h
+ Description:   Console logging that never blocks the caller. Each thread
+                queues into its own lock free buffer, a background thread
+                formats and writes them out.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "RingBuffer.h"
+
+#ifndef LOG_H
+#define LOG_H
+
+const int LOG_DEBUG = 0;
+const int LOG_INFO = 1;
+const int LOG_WARN = 2;
+const int LOG_ERROR = 3;
+const int LOG_LEVELS = 4;
+
+extern const char * LOG_LEVEL_NAMES[LOG_LEVELS];
+
+//LOG_* named name, -1 if there is none
+int logLevel(const std::string & name);
+
+const int LOG_ARGS = 3;
+
+struct LogEntry {
+  const char * format;    //must outlive the logger, string literals only
+  double args[LOG_ARGS];
+  int level;
+};
+
+//per thread, formatting happens on the flusher so entries stay small
+typedef RingBuffer<LogEntry, 256> LogBuffer;
+
+class Logger{
+  public:
+    Logger();
+    ~Logger();
+
+    //flusher thread, messages queue up before it starts and are written
+    //once it does
+    int start();
+
+    //writes out everything queued and stops the flusher
+    void stop();
+
+    //send every level to file instead of stdout / stderr, NULL for the
+    //console again. Only while the flusher is stopped
+    void redirect(FILE * file);
+
+    //any thread, never blocks. format takes up to LOG_ARGS doubles (%g,
+    //%.1f, ...) and no newline. Below level costs a load and a compare
+    void write(int at, const char * format, double a = 0, double b = 0, double c = 0) {
+      if(at >= level.load(std::memory_order_relaxed))
+        record(at, format, a, b, c);
+    }
+
+    //least LOG_* written, messages below it are dropped where they're made
+    std::atomic<int> level;
+
+    std::atomic<unsigned int> dropped;
+
+  private:
+    static int SDLCALL thread(void * data);
+
+    void record(int at, const char * format, double a, double b, double c);
+    LogBuffer * current();
+    void flush();
+
+    FILE * file;
+
+    std::atomic<bool> running;
+    SDL_Thread * handle;
+    SDL_sem * wake;
+
+    SDL_mutex * lock;
+    std::vector<LogBuffer *> buffers;
+};
+
+extern Logger logger;
+
+#endif /* LOG_H */
@@ -0,0 +1,226 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     MappedFile.cpp
+ Description:   Read only memory mapping of a whole file, or read / write
+                windows onto a file too large to map at once.
+ *****************************************************************************/
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+: bytes(NULL), length(0), total(0), granularity(0), file(INVALID_HANDLE_VALUE),
+  mapping(NULL) {}
+
+bool MappedFile::open(const std::string & path) {
+  close();
+
+  file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if(!GetFileSizeEx(file, &size)) {
+    close();
+    return false;
+  }
+  length = (size_t) size.QuadPart;
+
+  //empty files can't be mapped but are still valid
+  if(length == 0)
+    return true;
+
+  mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(mapping == NULL) {
+    close();
+    return false;
+  }
+
+  bytes = (const uint8_t *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if(bytes == NULL) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void MappedFile::close() {
+  if(bytes != NULL)
+    UnmapViewOfFile(bytes);
+  if(mapping != NULL)
+    CloseHandle(mapping);
+  if(file != INVALID_HANDLE_VALUE)
+    CloseHandle(file);
+
+  bytes = NULL;
+  length = 0;
+  total = 0;
+  mapping = NULL;
+  file = INVALID_HANDLE_VALUE;
+}
+
+bool MappedFile::edit(const std::string & path, uint64_t size) {
+  close();
+
+  file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+      OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER current;
+  if(!GetFileSizeEx(file, &current)) {
+    close();
+    return false;
+  }
+
+  //a new file only takes disk space where it gets written
+  if(current.QuadPart == 0) {
+    DWORD unused;
+    DeviceIoControl(file, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &unused, NULL);
+
+    current.QuadPart = (LONGLONG) size;
+    if(!SetFilePointerEx(file, current, NULL, FILE_BEGIN) || !SetEndOfFile(file)) {
+      close();
+      return false;
+    }
+  }
+  total = (uint64_t) current.QuadPart;
+
+  mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, 0, NULL);
+  if(mapping == NULL) {
+    close();
+    return false;
+  }
+
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  granularity = info.dwAllocationGranularity;
+
+  return true;
+}
+
+uint8_t * MappedFile::view(uint64_t offset, size_t count) {
+  uint64_t start = offset - offset % granularity;
+  size_t skip = (size_t) (offset - start);
+
+  void * base = MapViewOfFile(mapping, FILE_MAP_WRITE, (DWORD) (start >> 32), (DWORD) start,
+      skip + count);
+  return base != NULL ? (uint8_t *) base + skip : NULL;
+}
+
+void MappedFile::unview(uint8_t * at, size_t count) {
+  (void) count;
+
+  //views always begin on the granularity
+  UnmapViewOfFile(at - (uintptr_t) at % granularity);
+}
+
+#else
+
+MappedFile::MappedFile()
+: bytes(NULL), length(0), total(0), granularity(0), fd(-1) {}
+
+bool MappedFile::open(const std::string & path) {
+  close();
+
+  fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+
+  struct stat info;
+  if(fstat(fd, &info) < 0) {
+    close();
+    return false;
+  }
+  length = (size_t) info.st_size;
+
+  //empty files can't be mapped but are still valid
+  if(length == 0)
+    return true;
+
+  void * view = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(view == MAP_FAILED) {
+    close();
+    return false;
+  }
+
+  //playback reads front to back
+  madvise(view, length, MADV_SEQUENTIAL);
+  bytes = (const uint8_t *) view;
+
+  return true;
+}
+
+void MappedFile::close() {
+  if(bytes != NULL)
+    munmap((void *) bytes, length);
+  if(fd >= 0)
+    ::close(fd);
+
+  bytes = NULL;
+  length = 0;
+  total = 0;
+  fd = -1;
+}
+
+bool MappedFile::edit(const std::string & path, uint64_t size) {
+  close();
+
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if(fd < 0)
+    return false;
+
+  struct stat info;
+  if(fstat(fd, &info) < 0) {
+    close();
+    return false;
+  }
+
+  //a new file only takes disk space where it gets written
+  if(info.st_size == 0) {
+    if(ftruncate(fd, (off_t) size) < 0) {
+      close();
+      return false;
+    }
+    info.st_size = (off_t) size;
+  }
+  total = (uint64_t) info.st_size;
+  granularity = (size_t) sysconf(_SC_PAGESIZE);
+
+  return true;
+}
+
+uint8_t * MappedFile::view(uint64_t offset, size_t count) {
+  uint64_t start = offset - offset % granularity;
+  size_t skip = (size_t) (offset - start);
+
+  void * base = mmap(NULL, skip + count, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t) start);
+  return base != MAP_FAILED ? (uint8_t *) base + skip : NULL;
+}
+
+void MappedFile::unview(uint8_t * at, size_t count) {
+  //views always begin on the granularity
+  size_t skip = (uintptr_t) at % granularity;
+  munmap(at - skip, skip + count);
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+  close();
+}
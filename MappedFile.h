@@ -0,0 +1,56 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     MappedFile.h
+ Description:   Read only memory mapping of a whole file, or read / write
+                windows onto a file too large to map at once.
+ *****************************************************************************/
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+class MappedFile{
+  public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string & path);
+    void close();
+
+    const uint8_t * data() const { return bytes; }
+    size_t size() const { return length; }
+
+    //read / write with nothing mapped up front, path is created as a sparse
+    //file of size bytes if it doesn't exist yet
+    bool edit(const std::string & path, uint64_t size);
+    uint64_t fileSize() const { return total; }
+
+    //count bytes at offset of a file opened with edit(), any thread. Only
+    //pages that get touched take memory, and they're given back by unview
+    uint8_t * view(uint64_t offset, size_t count);
+    void unview(uint8_t * at, size_t count);
+
+  private:
+    MappedFile(const MappedFile &);
+    MappedFile & operator=(const MappedFile &);
+
+    const uint8_t * bytes;
+    size_t length;
+    uint64_t total;
+    size_t granularity;   //views start on multiples of this
+
+#ifdef _WIN32
+    void * file;
+    void * mapping;
+#else
+    int fd;
+#endif
+};
+
+#endif /* MAPPEDFILE_H */
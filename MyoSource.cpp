@@ -0,0 +1,171 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     MyoSource.cpp
+ Description:   Runs the Myo hub on its own thread and queues every event
+                the armband sends for the drawing loop.
+ *****************************************************************************/
+
+#ifndef NO_MYO
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "MyoSource.h"
+#include "Log.h"
+
+#include <iostream>
+
+//how long each hub.run() call on the input thread lasts, bounds stop() latency
+const unsigned int HUB_RUN_MS = 10;
+
+//how often to remind that no armband has paired yet
+const Uint32 HUB_WAIT_NOTE_MS = 10000;
+
+DataCollector::DataCollector(InputSource & source)
+: emg(false), paired(false), source(source), currentPose() {}
+
+void DataCollector::push(uint64_t timestamp, int type, int value) {
+  InputEvent e = {timestamp, type, value, {1, 0, 0, 0}};
+  source.push(e);
+}
+
+// onPair() is called for an armband already paired in Myo Connect on the first hub.run(), and again whenever
+// one pairs later, so the armband can come and go while we draw.
+void DataCollector::onPair(myo::Myo * myo, uint64_t timestamp) {
+  paired = true;
+  push(timestamp, EVENT_PAIR, 0);
+}
+
+// onConnect() is called every time the armband connects, streaming settings don't survive a reconnect.
+void DataCollector::onConnect(myo::Myo* myo, uint64_t timestamp, myo::FirmwareVersion firmwareVersion) {
+  if(emg)
+    myo->setStreamEmg(myo::Myo::streamEmgEnabled);
+}
+
+// onUnpair() is called whenever the Myo is disconnected from Myo Connect by the user.
+void DataCollector::onUnpair(myo::Myo* myo, uint64_t timestamp) {
+  // We've lost a Myo.
+  // Let the drawing loop clean up some leftover state.
+  paired = false;
+  push(timestamp, EVENT_UNPAIR, 0);
+}
+
+// onOrientationData() is called whenever the Myo device provides its current orientation, which is represented
+// as a unit quaternion.
+void DataCollector::onOrientationData(myo::Myo* myo, uint64_t timestamp, const myo::Quaternion<float>& quat) {
+  InputEvent e = {timestamp, EVENT_ORIENTATION, 0, {quat.w(), quat.x(), quat.y(), quat.z()}};
+  source.push(e);
+}
+
+// onGyroscopeData() and onAccelerometerData() pass on the raw IMU readings, in deg/s and g, for sensor fusion.
+void DataCollector::onGyroscopeData(myo::Myo* myo, uint64_t timestamp, const myo::Vector3<float>& gyro) {
+  InputEvent e = {timestamp, EVENT_GYROSCOPE, 0, {0, gyro.x(), gyro.y(), gyro.z()}};
+  source.push(e);
+}
+
+void DataCollector::onAccelerometerData(myo::Myo* myo, uint64_t timestamp, const myo::Vector3<float>& accel) {
+  InputEvent e = {timestamp, EVENT_ACCELEROMETER, 0, {0, accel.x(), accel.y(), accel.z()}};
+  source.push(e);
+}
+
+// onEmgData() is called 200 times a second with all eight channels once EMG streaming is on.
+void DataCollector::onEmgData(myo::Myo* myo, uint64_t timestamp, const int8_t* emg) {
+  InputEvent e = {timestamp, EVENT_EMG, 0, {1, 0, 0, 0}};
+  for(int c = 0; c < EMG_CHANNELS; c++)
+    e.emg[c] = emg[c];
+  source.push(e);
+}
+
+// onPose() is called whenever the Myo detects that the person wearing it has changed their pose, for example,
+// making a fist, or not making a fist anymore.
+void DataCollector::onPose(myo::Myo* myo, uint64_t timestamp, myo::Pose pose) {
+
+  if(pose == myo::Pose::fist) {
+    logger.write(LOG_INFO, "Fist pose");
+
+  } else if(currentPose == myo::Pose::fist) {
+    logger.write(LOG_INFO, "Fist stop");
+
+  }
+  currentPose = pose;
+
+  if(pose == myo::Pose::fist)
+    push(timestamp, EVENT_POSE, POSE_FIST);
+  else if(pose == myo::Pose::doubleTap)
+    push(timestamp, EVENT_POSE, POSE_TAP);
+  else if(pose == myo::Pose::fingersSpread)
+    push(timestamp, EVENT_POSE, POSE_SPREAD);
+  else
+    push(timestamp, EVENT_POSE, POSE_OTHER);
+}
+
+// onArmSync() is called whenever Myo has recognized a Sync Gesture after someone has put it on their
+// arm. This lets Myo know which arm it's on and which way it's facing.
+void DataCollector::onArmSync(myo::Myo* myo, uint64_t timestamp, myo::Arm arm, myo::XDirection xDirection,
+                              float rotation, myo::WarmupState warmupState) {
+  logger.write(LOG_INFO, "Arm sync successful.");
+  push(timestamp, EVENT_ARM_SYNC, arm);
+}
+
+// onArmUnsync() is called whenever Myo has detected that it was moved from a stable position on a person's arm after
+// it recognized the arm. Typically this happens when someone takes Myo off of their arm, but it can also happen
+// when Myo is moved around on the arm.
+void DataCollector::onArmUnsync(myo::Myo* myo, uint64_t timestamp) {
+  logger.write(LOG_INFO, "Arm unsynced.");
+  push(timestamp, EVENT_ARM_UNSYNC, 0);
+}
+
+// onUnlock() is called whenever Myo has become unlocked, and will start delivering pose events.
+void DataCollector::onUnlock(myo::Myo* myo, uint64_t timestamp) {
+  logger.write(LOG_INFO, "Unlocked.");
+  push(timestamp, EVENT_UNLOCK, 0);
+}
+
+// onLock() is called whenever Myo has become locked. No pose events will be sent until the Myo is unlocked again.
+void DataCollector::onLock(myo::Myo* myo, uint64_t timestamp) {
+  logger.write(LOG_INFO, "Locked.");
+  push(timestamp, EVENT_LOCK, 0);
+}
+
+// First, we create a Hub with our application identifier. Be sure not to use the com.example namespace when
+// publishing your application. The Hub provides access to one or more Myos.
+MyoSource::MyoSource(const std::string & appId)
+: hub(appId), collector(*this) {
+  hub.setLockingPolicy(myo::Hub::lockingPolicyNone);
+  // Hub::addListener() takes the address of any object whose class inherits from DeviceListener, and will cause
+  // Hub::run() to send events to all registered device listeners.
+  hub.addListener(&collector);
+}
+
+MyoSource::~MyoSource() {
+  stop();
+  hub.removeListener(&collector);
+}
+
+void MyoSource::streamEmg(bool on) {
+  collector.emg = on;
+}
+
+//input thread, all listener callbacks fire from in here. There is no
+//waitForMyo(), discovery is just more hub events so the window never waits
+void MyoSource::run() {
+  Uint32 note = SDL_GetTicks();
+
+  try {
+    while(running) {
+      hub.run(HUB_RUN_MS);
+
+      if(collector.paired) {
+        note = SDL_GetTicks();
+      }
+      else if(SDL_GetTicks() - note >= HUB_WAIT_NOTE_MS) {
+        logger.write(LOG_WARN, "Still looking for a Myo, is it paired in Myo Connect?");
+        note = SDL_GetTicks();
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Myo thread error: " << e.what() << std::endl;
+  }
+}
+
+#endif /* NO_MYO */
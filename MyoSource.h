@@ -0,0 +1,73 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     MyoSource.h
+ Description:   Runs the Myo hub on its own thread and queues every event
+                the armband sends for the drawing loop.
+ *****************************************************************************/
+
+
+#ifndef NO_MYO
+
+#include <myo/myo.hpp>
+#include <atomic>
+#include <string>
+#include "InputSource.h"
+
+#ifndef MYOSOURCE_H
+#define MYOSOURCE_H
+
+// Classes that inherit from myo::DeviceListener can be used to receive events from Myo devices. DeviceListener
+// provides several virtual functions for handling different kinds of events. If you do not override an event, the
+// default behavior is to do nothing.
+class DataCollector : public myo::DeviceListener {
+  public:
+    DataCollector(InputSource & source);
+
+    void onPair(myo::Myo * myo, uint64_t timestamp);
+    void onUnpair(myo::Myo* myo, uint64_t timestamp);
+    void onConnect(myo::Myo* myo, uint64_t timestamp, myo::FirmwareVersion firmwareVersion);
+    void onOrientationData(myo::Myo* myo, uint64_t timestamp, const myo::Quaternion<float>& quat);
+    void onGyroscopeData(myo::Myo* myo, uint64_t timestamp, const myo::Vector3<float>& gyro);
+    void onAccelerometerData(myo::Myo* myo, uint64_t timestamp, const myo::Vector3<float>& accel);
+    void onEmgData(myo::Myo* myo, uint64_t timestamp, const int8_t* emg);
+    void onPose(myo::Myo* myo, uint64_t timestamp, myo::Pose pose);
+    void onArmSync(myo::Myo* myo, uint64_t timestamp, myo::Arm arm, myo::XDirection xDirection, float rotation,
+                   myo::WarmupState warmupState);
+    void onArmUnsync(myo::Myo* myo, uint64_t timestamp);
+    void onUnlock(myo::Myo* myo, uint64_t timestamp);
+    void onLock(myo::Myo* myo, uint64_t timestamp);
+
+    //ask every armband that connects for its raw EMG stream
+    bool emg;
+
+    //an armband is paired right now
+    std::atomic<bool> paired;
+
+  private:
+    void push(uint64_t timestamp, int type, int value);
+
+    InputSource & source;
+    myo::Pose currentPose;
+};
+
+class MyoSource : public InputSource {
+  public:
+    MyoSource(const std::string & appId);
+    ~MyoSource();
+
+    //stream raw EMG as well, set before start()
+    void streamEmg(bool on);
+
+  protected:
+    void run();
+
+  private:
+    myo::Hub hub;
+    DataCollector collector;
+};
+
+#endif /* MYOSOURCE_H */
+
+#endif /* NO_MYO */
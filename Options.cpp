@@ -0,0 +1,343 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Options.cpp
+ Description:   Command line options.
+ *****************************************************************************/
+
+#include "Options.h"
+#include "Filter.h"
+#include "Log.h"
+#include "FrameScheduler.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef NO_MYO
+const char * DEFAULT_SOURCE = "synthetic";
+#else
+const char * DEFAULT_SOURCE = "myo";
+#endif
+
+Options::Options()
+: source(DEFAULT_SOURCE), speed(1), headless(false), frames(0), dumpEvery(0),
+  dumpDir("."), profileEvery(10), probe(0), predict("off"), filter("none"), minCutoff(1), beta(2), fusion(false), drift(true),
+  poses("myo"), gestureModel("gestures.txt"), pressure("roll"),
+  logLevel("info"), pacing("vsync"), fps(0), idle(true),
+  pan("edge"), canvasSize(65536), canvasMemory(256) {}
+
+void printUsage(const char * name) {
+  printf("Usage: %s [options]\n"
+      "  --source myo|synthetic|file  where armband events come from\n"
+      "  --file PATH                  recording for --source file\n"
+      "  --record PATH                write every input event to a binary recording\n"
+      "  --speed X                    playback speed, 0 = as fast as possible\n"
+      "  --pattern NAME               synthetic motion: still, circle, lissajous,\n"
+      "                               pauses, zigzag or walk\n"
+      "  --rate HZ                    synthetic orientation rate\n"
+      "  --imu-rate HZ                synthetic raw gyroscope / accelerometer rate\n"
+      "  --emg-rate HZ                synthetic raw EMG rate, the armband's is 200\n"
+      "  --duration S                 synthetic session length, 0 = forever\n"
+      "  --noise RAD                  synthetic jitter\n"
+      "  --yaw-drift RAD              synthetic heading drift per second\n"
+      "  --stroke ON OFF              synthetic seconds with fist held / released\n"
+      "  --clear-every S              synthetic seconds between spread poses\n"
+      "  --seed N                     synthetic random seed\n"
+      "  --headless                   render offscreen, exits when the input ends\n"
+      "  --frames N                   exit after N frames\n"
+      "  --dump-every N               save every Nth frame as frameNNNNNN.png\n"
+      "  --dump-dir DIR               directory for dumped frames\n"
+      "  --profile PATH               write stage timings to PATH.csv and PATH.json\n"
+      "  --profile-every S            seconds between timing exports\n"
+      "  --trace PATH                 write a Chrome / Perfetto timeline to PATH\n"
+      "  --latency-probe N            replace the input with N cursor jumps and\n"
+      "                               report input to present / pixel latency\n"
+      "  --predict off|cursor|tip     extrapolate the cursor, or the cursor and\n"
+      "                               stroke tip, to when the frame is shown\n"
+      "  --filter none|euro|slerp     smooth orientation jitter\n"
+      "  --min-cutoff HZ              filter cutoff while holding still\n"
+      "  --beta X                     One Euro cutoff added per rad/s of turning\n"
+      "  --fusion                     point from the gyroscope fused with the\n"
+      "                               armband's orientation, at the IMU rate\n"
+      "  --no-drift                   don't correct yaw drift learned while still\n"
+      "  --poses myo|emg              the armband's poses, or our own classifier\n"
+      "                               run on raw EMG\n"
+      "  --gesture-model PATH         classifier for --poses emg, from --bench-emg\n"
+      "  --pressure roll|emg          stroke width from twisting the wrist, or\n"
+      "                               width and opacity from how hard the fist\n"
+      "                               is squeezed\n"
+      "  --pacing MODE                vsync to the display's refresh, fixed at\n"
+      "                               --fps, or uncapped\n"
+      "  --fps HZ                     rate for --pacing fixed, 0 = refresh rate\n"
+      "  --no-idle                    draw every frame even when nothing changed\n"
+      "  --pan edge|off               scroll the canvas while the cursor is pushed\n"
+      "                               against an edge of the window\n"
+      "  --canvas-file PATH           keep the drawing in PATH, created sparse if\n"
+      "                               it doesn't exist, and pick it up again later\n"
+      "  --canvas-size PX             side of a new --canvas-file, centered on\n"
+      "                               where drawing starts\n"
+      "  --canvas-memory MB           most of a --canvas-file kept in memory\n"
+      "  --log-level LEVEL            least important messages printed, debug,\n"
+      "                               info, warn or error\n"
+      "  --bench-stroke               benchmark the stroke rasterizer\n"
+      "  --bench-pointer              benchmark orientation to screen mapping\n"
+      "  --bench-filter               jitter vs latency of each filter setting on\n"
+      "                               --source file or synthetic input\n"
+      "  --bench-fusion               accuracy, rate and cost of sensor fusion on\n"
+      "                               --source file or synthetic input\n"
+      "  --bench-drift                yaw drift found and corrected over a whole\n"
+      "                               --source file or synthetic session\n"
+      "  --bench-emg                  EMG feature cost, then train the classifier\n"
+      "                               on the first half of a --source file or\n"
+      "                               synthetic session, test it on the second\n"
+      "                               and save it to --gesture-model\n"
+      "  --bench-log                  cost of a log call on the hot path\n",
+      name);
+}
+
+//value after argv[n], NULL if missing
+static const char * value(int argc, char * argv[], int & n) {
+  if(n + 1 >= argc) {
+    printf("Missing value for %s\n", argv[n]);
+    return NULL;
+  }
+  return argv[++n];
+}
+
+int parseOptions(int argc, char * argv[], Options & opts) {
+  for(int n = 1; n < argc; n++) {
+    std::string arg = argv[n];
+    const char * v = NULL;
+
+    if(arg == "--bench-stroke") {
+      opts.bench = "stroke";
+      continue;
+    }
+    if(arg == "--bench-pointer") {
+      opts.bench = "pointer";
+      continue;
+    }
+    if(arg == "--bench-filter") {
+      opts.bench = "filter";
+      continue;
+    }
+    if(arg == "--bench-fusion") {
+      opts.bench = "fusion";
+      continue;
+    }
+    if(arg == "--fusion") {
+      opts.fusion = true;
+      continue;
+    }
+    if(arg == "--bench-drift") {
+      opts.bench = "drift";
+      continue;
+    }
+    if(arg == "--bench-emg") {
+      opts.bench = "emg";
+      continue;
+    }
+    if(arg == "--bench-log") {
+      opts.bench = "log";
+      continue;
+    }
+    if(arg == "--no-drift") {
+      opts.drift = false;
+      continue;
+    }
+    if(arg == "--no-idle") {
+      opts.idle = false;
+      continue;
+    }
+    if(arg == "--headless") {
+      opts.headless = true;
+      continue;
+    }
+    if(arg == "--help" || arg == "-h") {
+      printUsage(argv[0]);
+      return -1;
+    }
+    if(arg == "--stroke") {
+      if(!(v = value(argc, argv, n))) return -1;
+      opts.synthetic.strokeOn = atof(v);
+      if(!(v = value(argc, argv, n))) return -1;
+      opts.synthetic.strokeOff = atof(v);
+      continue;
+    }
+
+    //everything else takes one value
+    if(arg.compare(0, 2, "--") != 0 || !(v = value(argc, argv, n))) {
+      printUsage(argv[0]);
+      return -1;
+    }
+
+    if(arg == "--source")
+      opts.source = v;
+    else if(arg == "--file")
+      opts.file = v;
+    else if(arg == "--record")
+      opts.record = v;
+    else if(arg == "--speed")
+      opts.speed = atof(v);
+    else if(arg == "--pattern")
+      opts.synthetic.pattern = v;
+    else if(arg == "--rate")
+      opts.synthetic.rate = atof(v);
+    else if(arg == "--imu-rate")
+      opts.synthetic.imuRate = atof(v);
+    else if(arg == "--emg-rate")
+      opts.synthetic.emgRate = atof(v);
+    else if(arg == "--duration")
+      opts.synthetic.duration = atof(v);
+    else if(arg == "--noise")
+      opts.synthetic.noise = atof(v);
+    else if(arg == "--yaw-drift")
+      opts.synthetic.yawDrift = atof(v);
+    else if(arg == "--clear-every")
+      opts.synthetic.clearEvery = atof(v);
+    else if(arg == "--seed")
+      opts.synthetic.seed = atoi(v);
+    else if(arg == "--frames")
+      opts.frames = atoi(v);
+    else if(arg == "--dump-every")
+      opts.dumpEvery = atoi(v);
+    else if(arg == "--dump-dir")
+      opts.dumpDir = v;
+    else if(arg == "--profile")
+      opts.profile = v;
+    else if(arg == "--profile-every")
+      opts.profileEvery = atof(v);
+    else if(arg == "--trace")
+      opts.trace = v;
+    else if(arg == "--latency-probe")
+      opts.probe = atoi(v);
+    else if(arg == "--predict")
+      opts.predict = v;
+    else if(arg == "--filter")
+      opts.filter = v;
+    else if(arg == "--min-cutoff")
+      opts.minCutoff = atof(v);
+    else if(arg == "--beta")
+      opts.beta = atof(v);
+    else if(arg == "--poses")
+      opts.poses = v;
+    else if(arg == "--gesture-model")
+      opts.gestureModel = v;
+    else if(arg == "--pressure")
+      opts.pressure = v;
+    else if(arg == "--pan")
+      opts.pan = v;
+    else if(arg == "--canvas-file")
+      opts.canvasFile = v;
+    else if(arg == "--canvas-size")
+      opts.canvasSize = atoi(v);
+    else if(arg == "--canvas-memory")
+      opts.canvasMemory = atoi(v);
+    else if(arg == "--log-level")
+      opts.logLevel = v;
+    else if(arg == "--pacing")
+      opts.pacing = v;
+    else if(arg == "--fps")
+      opts.fps = atof(v);
+    else {
+      printf("Unknown option %s\n", arg.c_str());
+      printUsage(argv[0]);
+      return -1;
+    }
+  }
+
+  opts.synthetic.speed = opts.speed;
+
+  float yaw, pitch;
+  const std::string & pattern = opts.synthetic.pattern;
+  if(pattern != "walk" && !SyntheticSource::motion(pattern, 0, yaw, pitch)) {
+    printf("Unknown pattern %s\n", pattern.c_str());
+    return -1;
+  }
+
+  if(opts.synthetic.rate <= 0) {
+    printf("Rate must be positive\n");
+    return -1;
+  }
+
+  if(opts.source == "file" && opts.file.empty()) {
+    printf("--source file needs --file\n");
+    return -1;
+  }
+
+  if(opts.source != "myo" && opts.source != "synthetic" && opts.source != "file") {
+    printf("Unknown source %s\n", opts.source.c_str());
+    return -1;
+  }
+
+  if(opts.predict != "off" && opts.predict != "cursor" && opts.predict != "tip") {
+    printf("Unknown prediction %s\n", opts.predict.c_str());
+    return -1;
+  }
+
+  if(filterType(opts.filter) < 0) {
+    printf("Unknown filter %s\n", opts.filter.c_str());
+    return -1;
+  }
+
+  if(opts.minCutoff <= 0 || opts.beta < 0) {
+    printf("Filter cutoff must be positive\n");
+    return -1;
+  }
+
+  if(opts.poses != "myo" && opts.poses != "emg") {
+    printf("Unknown pose source %s\n", opts.poses.c_str());
+    return -1;
+  }
+
+  if(opts.pressure != "roll" && opts.pressure != "emg") {
+    printf("Unknown pressure source %s\n", opts.pressure.c_str());
+    return -1;
+  }
+
+  if(opts.pan != "edge" && opts.pan != "off") {
+    printf("Unknown panning %s\n", opts.pan.c_str());
+    return -1;
+  }
+
+  if(opts.canvasSize < 4096 || opts.canvasSize > 262144) {
+    printf("Canvas size must be 4096 to 262144 pixels\n");
+    return -1;
+  }
+
+  if(opts.canvasMemory < 16) {
+    printf("Canvas memory must be at least 16 MB\n");
+    return -1;
+  }
+
+  if(pacingMode(opts.pacing) < 0) {
+    printf("Unknown pacing %s\n", opts.pacing.c_str());
+    return -1;
+  }
+
+  if(opts.fps < 0) {
+    printf("Frame rate can't be negative\n");
+    return -1;
+  }
+
+  if(logLevel(opts.logLevel) < 0) {
+    printf("Unknown log level %s\n", opts.logLevel.c_str());
+    return -1;
+  }
+
+  if(opts.headless && opts.frames == 0 && opts.probe == 0 && opts.source == "synthetic" &&
+      opts.synthetic.duration <= 0) {
+    printf("Headless synthetic runs need --frames or --duration\n");
+    return -1;
+  }
+
+#ifdef NO_MYO
+  if(opts.source == "myo" && opts.probe == 0) {
+    printf("Built without the Myo SDK, use --source synthetic or file\n");
+    return -1;
+  }
+#endif
+
+  return 0;
+}
@@ -0,0 +1,57 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Options.h
+ Description:   Command line options.
+ *****************************************************************************/
+
+
+#include <string>
+#include "SyntheticSource.h"
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+struct Options {
+  std::string source;       //myo, synthetic or file
+  std::string file;         //recording played by the file source
+  std::string record;       //binary recording written while running
+  std::string bench;        //benchmark to run instead of drawing
+  float speed;              //playback speed of synthetic and file sources
+  bool headless;            //render offscreen without a window
+  unsigned int frames;      //stop after this many frames, 0 runs on
+  unsigned int dumpEvery;   //save every Nth frame as a PNG, 0 saves none
+  std::string dumpDir;      //where dumped frames go
+  std::string profile;      //stage timings go to profile.csv / profile.json
+  float profileEvery;       //seconds between timing exports
+  std::string trace;        //Chrome trace event timeline
+  unsigned int probe;       //latency probe steps, 0 draws normally
+  std::string predict;      //extrapolate off, the cursor, or cursor and stroke tip
+  std::string filter;       //orientation smoothing, none, euro or slerp
+  float minCutoff;          //filter cutoff while still, Hz
+  float beta;               //One Euro cutoff added per rad/s
+  bool fusion;              //point from the fused gyroscope / accelerometer
+  bool drift;               //learn yaw drift while still and correct the center
+  std::string poses;        //pose source, the armband's own myo or emg
+  std::string gestureModel; //classifier --poses emg loads and --bench-emg saves
+  std::string pressure;     //stroke width from the wrist's roll, or emg grip
+  std::string logLevel;     //least level of console messages written
+  std::string pacing;       //frame pacing, vsync, fixed or uncapped
+  float fps;                //fixed pacing rate, 0 for the display's refresh
+  bool idle;                //skip frames that would look like the last one
+  std::string pan;          //move the view by pushing the cursor at an edge, or off
+  std::string canvasFile;   //keep the drawing in this file, empty keeps it in memory
+  int canvasSize;           //side in pixels of a new canvas file
+  int canvasMemory;         //MB of a file backed canvas kept in memory
+  SyntheticConfig synthetic;
+
+  Options();
+};
+
+//fills opts from argv, prints usage and returns -1 on bad arguments
+int parseOptions(int argc, char * argv[], Options & opts);
+
+void printUsage(const char * name);
+
+#endif /* OPTIONS_H */
@@ -0,0 +1,124 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Pointer.cpp
+ Description:   Maps armband orientation to the screen by projecting where
+                the forearm points onto a plane in front of the user.
+ *****************************************************************************/
+
+#include "Pointer.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+//widest stroke, reached with the wrist turned all the way round
+const float MAX_RADIUS = 4.5f;
+
+void PointerBatch::resize(size_t count) {
+  w.resize(count);
+  x.resize(count);
+  y.resize(count);
+  z.resize(count);
+  px.resize(count);
+  py.resize(count);
+  radius.resize(count);
+}
+
+Pointer::Pointer(int width, int height, float sensX, float sensY)
+: yaw(0), centerX(width / 2.0f), centerY(height / 2.0f),
+  scaleX((float) (sensX * width / (2 * M_PI))), scaleY((float) (sensY * height / M_PI)),
+  signX(1), signY(1) {
+  float identity[4] = {1, 0, 0, 0};
+  recenter(identity);
+}
+
+void Pointer::recenter(const float quat[4]) {
+  for(int n = 0; n < 4; n++)
+    reference[n] = quat[n];
+  yaw = 0;
+  rows();
+}
+
+void Pointer::drift(float yaw) {
+  if(yaw == this->yaw)
+    return;
+  this->yaw = yaw;
+  rows();
+}
+
+//rows 2 and 3 of the transpose of the reference, turned by yaw about the
+//world's vertical
+void Pointer::rows() {
+  float c = std::cos(yaw / 2);
+  float s = std::sin(yaw / 2);
+  const float * r = reference;
+
+  float w = c * r[0] - s * r[3];
+  float x = c * r[1] - s * r[2];
+  float y = c * r[2] + s * r[1];
+  float z = c * r[3] + s * r[0];
+
+  side[0] = 2 * (x * y - w * z);
+  side[1] = 1 - 2 * (x * x + z * z);
+  side[2] = 2 * (y * z + w * x);
+
+  up[0] = 2 * (x * z + w * y);
+  up[1] = 2 * (y * z - w * x);
+  up[2] = 1 - 2 * (x * x + y * y);
+}
+
+void Pointer::invert(bool x, bool y) {
+  signX = x ? -1.0f : 1.0f;
+  signY = y ? -1.0f : 1.0f;
+}
+
+//monotonic stand-in for atan2(b, a) / 2pi + 0.5, 0 at -pi up to 1 at pi,
+//exact every eighth of a turn
+static inline float turn(float b, float a) {
+  float sum = std::fabs(a) + std::fabs(b);
+  if(sum == 0)
+    return 0.5f;
+
+  //diamond angle, 0 to 4 counterclockwise from +a
+  float d = b >= 0 ? (a >= 0 ? b / sum : 1 - a / sum)
+                   : (a < 0 ? 2 - b / sum : 3 + a / sum);
+
+  float t = d / 4 + 0.5f;
+  return t >= 1 ? t - 1 : t;
+}
+
+void Pointer::map(PointerBatch & batch, size_t begin, size_t end) {
+  const float * qw = &batch.w[0];
+  const float * qx = &batch.x[0];
+  const float * qy = &batch.y[0];
+  const float * qz = &batch.z[0];
+  float * px = &batch.px[0];
+  float * py = &batch.py[0];
+  float * radius = &batch.radius[0];
+
+  for(size_t n = begin; n < end; n++) {
+    float w = qw[n];
+    float x = qx[n];
+    float y = qy[n];
+    float z = qz[n];
+
+    //forearm (the armband's x axis) in the world
+    float fx = 1 - 2 * (y * y + z * z);
+    float fy = 2 * (x * y + w * z);
+    float fz = 2 * (x * z - w * y);
+
+    //sideways and upwards from the reference direction, orthographic so
+    //there is no wrap around anywhere in front of the user
+    float s = side[0] * fx + side[1] * fy + side[2] * fz;
+    float u = up[0] * fx + up[1] * fy + up[2] * fz;
+
+    px[n] = centerX - signX * scaleX * s;
+    py[n] = centerY + signY * scaleY * u;
+
+    //wrist roll from the z parts of the band's y and z axes
+    float ry = 2 * (y * z + w * x);
+    float rz = 1 - 2 * (x * x + y * y);
+    radius[n] = MAX_RADIUS * turn(ry, rz);
+  }
+}
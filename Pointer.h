@@ -0,0 +1,57 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Pointer.h
+ Description:   Maps armband orientation to the screen by projecting where
+                the forearm points onto a plane in front of the user.
+ *****************************************************************************/
+
+
+#include <vector>
+#include <stddef.h>
+
+#ifndef POINTER_H
+#define POINTER_H
+
+//samples mapped in one call, one array per component so the loop vectorizes
+struct PointerBatch {
+  std::vector<float> w, x, y, z;      //orientation quaternions in
+  std::vector<float> px, py, radius;  //screen position and stroke radius out
+
+  void resize(size_t count);
+};
+
+class Pointer{
+  public:
+    //sensX / sensY are screen widths / heights per half turn of the arm
+    Pointer(int width, int height, float sensX, float sensY);
+
+    //from here on the arm pointing like quat w, x, y, z is the screen center
+    void recenter(const float quat[4]);
+
+    //turn the center about the vertical by yaw radians, for drift
+    void drift(float yaw);
+
+    void invert(bool x, bool y);
+
+    //fill px, py and radius of batch entries [begin, end)
+    void map(PointerBatch & batch, size_t begin, size_t end);
+
+  private:
+    void rows();
+
+    float reference[4];
+    float yaw;
+
+    //world forearm direction to the reference frame, only the rows
+    //that end up on screen
+    float side[3];
+    float up[3];
+
+    float centerX, centerY;
+    float scaleX, scaleY;
+    float signX, signY;
+};
+
+#endif /* POINTER_H */
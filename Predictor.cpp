@@ -0,0 +1,110 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Predictor.cpp
+ Description:   Extrapolates the cursor from recent timestamped samples to
+                the time the frame being drawn reaches the screen.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "Predictor.h"
+
+#include <algorithm>
+
+//never extrapolate further than this, the arm can turn around in less
+const double PREDICT_MAX_US = 50000;
+
+//how quickly the measured lead and clock offset follow changes
+const double LEAD_RATE = 0.1;
+const double OFFSET_RATE = 0.001;
+
+Predictor::Predictor()
+: count(0), synced(false), offset(0), leadUs(0), toMicros(0) {}
+
+void Predictor::reset() {
+  count = 0;
+  synced = false;
+}
+
+void Predictor::add(uint64_t timestamp, float x, float y, Uint64 now) {
+  if(toMicros == 0)
+    toMicros = 1000000.0 / SDL_GetPerformanceFrequency();
+
+  //replays start over, pose events repeat the last orientation's stamp
+  if(count > 0 && timestamp < history[count - 1].timestamp)
+    reset();
+  if(count > 0 && timestamp == history[count - 1].timestamp) {
+    history[count - 1].x = x;
+    history[count - 1].y = y;
+    return;
+  }
+
+  //follow the floor of the delay, creeping up slowly in case the clocks drift
+  double delay = now * toMicros - (double) timestamp;
+  if(!synced || delay < offset)
+    offset = delay;
+  else
+    offset += (delay - offset) * OFFSET_RATE;
+  synced = true;
+
+  if(count == 3) {
+    history[0] = history[1];
+    history[1] = history[2];
+    count = 2;
+  }
+
+  Point p = {timestamp, x, y};
+  history[count++] = p;
+}
+
+void Predictor::predict(Uint64 when, float & x, float & y) {
+  if(count == 0)
+    return;
+
+  const Point & p2 = history[count - 1];
+  x = p2.x;
+  y = p2.y;
+
+  if(count < 2 || !synced)
+    return;
+
+  double h = when * toMicros - offset - (double) p2.timestamp;
+  h = std::min(std::max(h, 0.0), PREDICT_MAX_US);
+
+  //velocity over the last interval, carried forward to the newest sample
+  //by the change from the interval before it
+  const Point & p1 = history[count - 2];
+  double dt = (double) (p2.timestamp - p1.timestamp);
+  double vx = (p2.x - p1.x) / dt;
+  double vy = (p2.y - p1.y) / dt;
+  double ax = 0;
+  double ay = 0;
+
+  if(count == 3) {
+    const Point & p0 = history[0];
+    double dt0 = (double) (p1.timestamp - p0.timestamp);
+    double span = (p2.timestamp - p0.timestamp) / 2.0;
+    ax = (vx - (p1.x - p0.x) / dt0) / span;
+    ay = (vy - (p1.y - p0.y) / dt0) / span;
+    vx += ax * dt / 2;
+    vy += ay * dt / 2;
+  }
+
+  x = p2.x + vx * h + 0.5 * ax * h * h;
+  y = p2.y + vy * h + 0.5 * ay * h * h;
+}
+
+Uint64 Predictor::lead() {
+  if(toMicros == 0)
+    return 0;
+  return (Uint64) (leadUs / toMicros);
+}
+
+void Predictor::presented(Uint64 latched) {
+  if(toMicros == 0)
+    toMicros = 1000000.0 / SDL_GetPerformanceFrequency();
+
+  double us = (SDL_GetPerformanceCounter() - latched) * toMicros;
+  leadUs = leadUs == 0 ? us : leadUs + (us - leadUs) * LEAD_RATE;
+}
@@ -0,0 +1,55 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Predictor.h
+ Description:   Extrapolates the cursor from recent timestamped samples to
+                the time the frame being drawn reaches the screen.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+
+#ifndef PREDICTOR_H
+#define PREDICTOR_H
+
+class Predictor{
+  public:
+    Predictor();
+
+    void reset();
+
+    //a sample already mapped to the screen, stamped by the armband and
+    //drained at performance counter value now
+    void add(uint64_t timestamp, float x, float y, Uint64 now);
+
+    //where the cursor will be at performance counter value when
+    void predict(Uint64 when, float & x, float & y);
+
+    //counter ticks from latching input to the present returning, as measured
+    Uint64 lead();
+
+    //the frame latched at counter value latched just finished presenting
+    void presented(Uint64 latched);
+
+  private:
+    struct Point {
+      uint64_t timestamp;
+      float x, y;
+    };
+
+    //newest last
+    Point history[3];
+    int count;
+
+    //host microseconds minus armband microseconds, the smallest seen is
+    //the sample that waited least before being drained
+    bool synced;
+    double offset;
+
+    double leadUs;
+    double toMicros;
+};
+
+#endif /* PREDICTOR_H */
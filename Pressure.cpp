@@ -0,0 +1,77 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Pressure.cpp
+ Description:   Grip pressure from the smoothed EMG envelope while a fist is
+                held, measured on the input thread.
+ *****************************************************************************/
+
+#include "Pressure.h"
+
+#include <cmath>
+#include <algorithm>
+
+//envelope time constant, the pressure trails the muscles by about this
+const double PRESSURE_TAU = 0.04;
+
+//how slowly the relaxed level and the remembered hardest grip move
+const double PRESSURE_REST_TAU = 2;
+const double PRESSURE_PEAK_TAU = 20;
+
+//least envelope between relaxed and full pressure, so the first light grip
+//isn't taken for the hardest
+const double PRESSURE_RANGE = 15;
+
+//a gap this long means the EMG stream restarted
+const uint64_t PRESSURE_GAP_US = 100000;
+
+Pressure::Pressure()
+: enabled(false), pose(POSE_OTHER), last(0), primed(false), envelope(0), rest(0),
+  peak(PRESSURE_RANGE) {}
+
+void Pressure::apply(InputEvent & e) {
+  if(!enabled)
+    return;
+
+  if(e.type == EVENT_POSE) {
+    pose = e.value;
+    return;
+  }
+  if(e.type != EVENT_EMG)
+    return;
+
+  double level = 0;
+  for(int c = 0; c < EMG_CHANNELS; c++)
+    level += std::abs((int) e.emg[c]);
+  level /= EMG_CHANNELS;
+
+  if(!primed || e.timestamp <= last || e.timestamp - last > PRESSURE_GAP_US) {
+    if(!primed)
+      rest = level;
+    envelope = level;
+    primed = true;
+    last = e.timestamp;
+  }
+
+  //one pole low pass, weighted by the real gap between samples
+  double dt = (e.timestamp - last) / 1000000.0;
+  last = e.timestamp;
+  envelope += (1 - std::exp(-dt / PRESSURE_TAU)) * (level - envelope);
+
+  if(pose != POSE_FIST) {
+    rest += (1 - std::exp(-dt / PRESSURE_REST_TAU)) * (envelope - rest);
+    e.value = 0;
+  }
+  else {
+    //the hardest grip fades so one squeeze doesn't flatten every later one
+    peak = rest + (peak - rest) * std::exp(-dt / PRESSURE_PEAK_TAU);
+    peak = std::max(peak, envelope);
+  }
+  peak = std::max(peak, rest + PRESSURE_RANGE);
+
+  if(pose == POSE_FIST) {
+    double p = (envelope - rest) / (peak - rest);
+    e.value = (int) (std::min(1.0, std::max(0.0, p)) * PRESSURE_STEPS + 0.5);
+  }
+}
@@ -0,0 +1,37 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Pressure.h
+ Description:   Grip pressure from the smoothed EMG envelope while a fist is
+                held, measured on the input thread.
+ *****************************************************************************/
+
+
+#include <atomic>
+#include "Input.h"
+
+#ifndef PRESSURE_H
+#define PRESSURE_H
+
+class Pressure{
+  public:
+    Pressure();
+
+    //input thread, in event order after the pose stage. EMG events leave
+    //with value set to the pressure, 0 unless a fist is held
+    void apply(InputEvent & e);
+
+    std::atomic<bool> enabled;
+
+  private:
+    int pose;
+    uint64_t last;
+    bool primed;
+
+    double envelope;  //mean rectified EMG, low passed
+    double rest;      //envelope with the hand relaxed
+    double peak;      //hardest grip lately
+};
+
+#endif /* PRESSURE_H */
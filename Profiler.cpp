@@ -0,0 +1,179 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Profiler.cpp
+ Description:   High resolution timers around each stage of the frame loop,
+                collected into fixed bucket histograms.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "Profiler.h"
+#include "Tracer.h"
+
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+
+const char * STAGE_NAMES[STAGE_COUNT] = {
+  "events", "input", "map", "stroke", "upload", "copy", "present", "latch", "pace", "frame"
+};
+
+const double HISTOGRAM_MIN_US = 0.1;
+const double HISTOGRAM_PER_OCTAVE = 8;
+
+Profiler profiler;
+
+Histogram::Histogram() {
+  reset();
+}
+
+void Histogram::reset() {
+  count = 0;
+  sum = 0;
+  max = 0;
+  memset(buckets, 0, sizeof(buckets));
+}
+
+void Histogram::add(double us) {
+  int b = 0;
+  if(us > HISTOGRAM_MIN_US)
+    b = (int) (std::log2(us / HISTOGRAM_MIN_US) * HISTOGRAM_PER_OCTAVE) + 1;
+  if(b >= HISTOGRAM_BUCKETS)
+    b = HISTOGRAM_BUCKETS - 1;
+
+  buckets[b]++;
+  count++;
+  sum += us;
+  if(us > max)
+    max = us;
+}
+
+double Histogram::percentile(double p) const {
+  if(count == 0)
+    return 0;
+
+  double rank = p / 100.0 * count;
+  unsigned int seen = 0;
+
+  for(int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+    seen += buckets[b];
+    if(seen >= rank && seen > 0) {
+      double edge = HISTOGRAM_MIN_US * std::pow(2.0, b / HISTOGRAM_PER_OCTAVE);
+      return edge < max ? edge : max;
+    }
+  }
+  return max;
+}
+
+double Histogram::mean() const {
+  return count ? sum / count : 0;
+}
+
+Profiler::Profiler()
+: toMicros(0), every(0), origin(0), lastExport(0), csvStarted(false) {
+  memset(started, 0, sizeof(started));
+}
+
+void Profiler::begin(int stage) {
+  tracer.begin(STAGE_NAMES[stage]);
+  started[stage] = SDL_GetPerformanceCounter();
+}
+
+void Profiler::end(int stage) {
+  //the performance counter isn't usable before SDL_Init on every platform
+  if(toMicros == 0)
+    toMicros = 1000000.0 / SDL_GetPerformanceFrequency();
+
+  double us = (SDL_GetPerformanceCounter() - started[stage]) * toMicros;
+  interval[stage].add(us);
+  total[stage].add(us);
+  tracer.end(STAGE_NAMES[stage]);
+}
+
+void Profiler::exportTo(const std::string & path, double interval) {
+  this->path = path;
+  every = interval;
+  origin = lastExport = SDL_GetPerformanceCounter();
+}
+
+void Profiler::tick() {
+  if(path.empty() || every <= 0)
+    return;
+
+  Uint64 now = SDL_GetPerformanceCounter();
+  if((now - lastExport) < every * SDL_GetPerformanceFrequency())
+    return;
+
+  lastExport = now;
+  write(false);
+}
+
+void Profiler::finish() {
+  if(!path.empty())
+    write(true);
+}
+
+static void csvRows(FILE * f, double time, const char * window, const Histogram * h) {
+  for(int s = 0; s < STAGE_COUNT; s++)
+    fprintf(f, "%.3f,%s,%s,%u,%.2f,%.2f,%.2f,%.2f,%.2f\n", time, window, STAGE_NAMES[s],
+        h[s].count, h[s].mean(), h[s].percentile(50), h[s].percentile(95),
+        h[s].percentile(99), h[s].max);
+}
+
+static void jsonStages(FILE * f, const Histogram * h) {
+  fprintf(f, "{\n");
+  for(int s = 0; s < STAGE_COUNT; s++)
+    fprintf(f, "    \"%s\": {\"count\": %u, \"mean_us\": %.2f, \"p50_us\": %.2f, "
+        "\"p95_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f}%s\n", STAGE_NAMES[s],
+        h[s].count, h[s].mean(), h[s].percentile(50), h[s].percentile(95),
+        h[s].percentile(99), h[s].max, s + 1 < STAGE_COUNT ? "," : "");
+  fprintf(f, "  }");
+}
+
+//csv gets a row per stage for every interval, json is rewritten each time
+void Profiler::write(bool last) {
+  double time = (SDL_GetPerformanceCounter() - origin) / (double) SDL_GetPerformanceFrequency();
+
+  FILE * csv = fopen((path + ".csv").c_str(), csvStarted ? "a" : "w");
+  if(csv != NULL) {
+    if(!csvStarted)
+      fprintf(csv, "time_s,window,stage,count,mean_us,p50_us,p95_us,p99_us,max_us\n");
+    csvStarted = true;
+
+    csvRows(csv, time, "interval", interval);
+    if(last)
+      csvRows(csv, time, "total", total);
+    fclose(csv);
+  }
+  else {
+    printf("Unable to write %s.csv\n", path.c_str());
+  }
+
+  FILE * json = fopen((path + ".json").c_str(), "w");
+  if(json != NULL) {
+    fprintf(json, "{\n  \"time_s\": %.3f,\n  \"final\": %s,\n  \"interval\": ", time,
+        last ? "true" : "false");
+    jsonStages(json, interval);
+    fprintf(json, ",\n  \"total\": ");
+    jsonStages(json, total);
+    fprintf(json, "\n}\n");
+    fclose(json);
+  }
+  else {
+    printf("Unable to write %s.json\n", path.c_str());
+  }
+
+  for(int s = 0; s < STAGE_COUNT; s++)
+    interval[s].reset();
+}
+
+void Profiler::print() {
+  printf("%-8s %8s %10s %10s %10s %10s %10s\n", "stage", "count", "mean us",
+      "p50 us", "p95 us", "p99 us", "max us");
+  for(int s = 0; s < STAGE_COUNT; s++) {
+    const Histogram & h = total[s];
+    printf("%-8s %8u %10.1f %10.1f %10.1f %10.1f %10.1f\n", STAGE_NAMES[s], h.count,
+        h.mean(), h.percentile(50), h.percentile(95), h.percentile(99), h.max);
+  }
+}
@@ -0,0 +1,88 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Profiler.h
+ Description:   High resolution timers around each stage of the frame loop,
+                collected into fixed bucket histograms.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <string>
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+const int STAGE_EVENTS = 0;   //Display::handleEvents
+const int STAGE_INPUT = 1;    //draining the input queue
+const int STAGE_MAP = 2;      //orientation to cursor position
+const int STAGE_STROKE = 3;   //stroke rasterization and clears
+const int STAGE_UPLOAD = 4;   //changed canvas tiles to their textures
+const int STAGE_COPY = 5;     //SDL_RenderCopy of canvas tiles and cursors
+const int STAGE_PRESENT = 6;  //SDL_RenderPresent
+const int STAGE_LATCH = 7;    //late input and cursor prediction
+const int STAGE_PACE = 8;     //waiting for a fixed rate frame to be due
+const int STAGE_FRAME = 9;    //the whole loop iteration
+const int STAGE_COUNT = 10;
+
+extern const char * STAGE_NAMES[STAGE_COUNT];
+
+//log spaced buckets, 8 per octave from 0.1 us up to about 50 s
+const int HISTOGRAM_BUCKETS = 232;
+
+class Histogram{
+  public:
+    Histogram();
+
+    void add(double us);
+    void reset();
+
+    //upper edge of the bucket holding the p-th percentile, p in 0..100
+    double percentile(double p) const;
+    double mean() const;
+
+    unsigned int count;
+    double sum;
+    double max;
+
+  private:
+    unsigned int buckets[HISTOGRAM_BUCKETS];
+};
+
+class Profiler{
+  public:
+    Profiler();
+
+    void begin(int stage);
+    void end(int stage);
+
+    //export files are path + ".csv" and path + ".json", written every
+    //interval seconds from tick() and once more from finish()
+    void exportTo(const std::string & path, double interval);
+    void tick();
+    void finish();
+
+    //p50/p95/p99/max per stage to stdout
+    void print();
+
+    //since the last export, and since the start
+    Histogram interval[STAGE_COUNT];
+    Histogram total[STAGE_COUNT];
+
+  private:
+    void write(bool last);
+
+    Uint64 started[STAGE_COUNT];
+    double toMicros;
+
+    std::string path;
+    double every;
+    Uint64 origin;
+    Uint64 lastExport;
+    bool csvStarted;
+};
+
+extern Profiler profiler;
+
+#endif /* PROFILER_H */
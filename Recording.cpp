@@ -0,0 +1,281 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Recording.cpp
+ Description:   Compact binary log of armband events, written while a
+                session runs and read back through a memory mapping.
+ *****************************************************************************/
+
+#include "Recording.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+//write buffered events out in chunks this big
+const size_t RECORDER_CHUNK = 64 * 1024;
+
+//quaternion components other than the largest lie within +-1/sqrt(2)
+const float QUAT_RANGE = 0.70710678f;
+const float QUAT_SCALE = 32767.0f / QUAT_RANGE;
+
+//steps per deg/s and per g, the armband reads up to 2000 deg/s and 16 g
+const float GYRO_SCALE = 16.0f;
+const float ACCEL_SCALE = 2048.0f;
+
+static float vectorScale(int type) {
+  return type == EVENT_GYROSCOPE ? GYRO_SCALE : ACCEL_SCALE;
+}
+
+Recorder::Recorder()
+: file(NULL), first(true), last(0), events(0) {}
+
+Recorder::~Recorder() {
+  close();
+}
+
+bool Recorder::open(const std::string & path) {
+  close();
+
+  file = fopen(path.c_str(), "wb");
+  if(file == NULL)
+    return false;
+
+  buffer.clear();
+  buffer.reserve(RECORDER_CHUNK + 64);
+  first = true;
+  last = 0;
+  events = 0;
+  return true;
+}
+
+void Recorder::close() {
+  if(file == NULL)
+    return;
+
+  //header still unwritten if no events arrived
+  if(first)
+    header(0);
+
+  flush();
+  fclose(file);
+  file = NULL;
+}
+
+void Recorder::flush() {
+  if(!buffer.empty())
+    fwrite(&buffer[0], 1, buffer.size(), file);
+  buffer.clear();
+}
+
+void Recorder::header(uint64_t timestamp) {
+  first = false;
+  last = timestamp;
+
+  buffer.insert(buffer.end(), RECORDING_MAGIC, RECORDING_MAGIC + 4);
+  buffer.push_back(RECORDING_VERSION);
+  buffer.push_back(0);
+  buffer.push_back(0);
+  buffer.push_back(0);
+  for(int n = 0; n < 8; n++)
+    buffer.push_back((uint8_t) (timestamp >> (8 * n)));
+}
+
+static void putVarint(std::vector<uint8_t> & out, uint64_t v) {
+  while(v >= 0x80) {
+    out.push_back((uint8_t) (v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t) v);
+}
+
+static void putInt16(std::vector<uint8_t> & out, int16_t v) {
+  out.push_back((uint8_t) (v & 0xFF));
+  out.push_back((uint8_t) ((uint16_t) v >> 8));
+}
+
+void Recorder::write(const InputEvent & e) {
+  if(file == NULL)
+    return;
+
+  if(first)
+    header(e.timestamp);
+
+  //zigzag so an out of order timestamp still round trips
+  int64_t delta = (int64_t) (e.timestamp - last);
+  uint64_t zigzag = ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63);
+  last = e.timestamp;
+
+  if(e.type == EVENT_ORIENTATION) {
+    //smallest three, q and -q are the same rotation so the dropped
+    //component is always rebuilt positive
+    int largest = 0;
+    for(int n = 1; n < 4; n++)
+      if(std::fabs(e.quat[n]) > std::fabs(e.quat[largest]))
+        largest = n;
+
+    float sign = e.quat[largest] < 0 ? -1.0f : 1.0f;
+
+    buffer.push_back((uint8_t) (e.type | (largest << 4)));
+    putVarint(buffer, zigzag);
+
+    for(int n = 0; n < 4; n++) {
+      if(n == largest)
+        continue;
+      float v = sign * e.quat[n] * QUAT_SCALE;
+      v = std::max(-32767.0f, std::min(32767.0f, v));
+      putInt16(buffer, (int16_t) std::floor(v + 0.5f));
+    }
+  }
+  else {
+    buffer.push_back((uint8_t) e.type);
+    putVarint(buffer, zigzag);
+
+    if(e.type == EVENT_POSE || e.type == EVENT_ARM_SYNC)
+      buffer.push_back((uint8_t) e.value);
+
+    if(e.type == EVENT_GYROSCOPE || e.type == EVENT_ACCELEROMETER) {
+      float scale = vectorScale(e.type);
+      for(int n = 1; n < 4; n++) {
+        float v = e.quat[n] * scale;
+        v = std::max(-32767.0f, std::min(32767.0f, v));
+        putInt16(buffer, (int16_t) std::floor(v + 0.5f));
+      }
+    }
+
+    if(e.type == EVENT_EMG)
+      for(int c = 0; c < EMG_CHANNELS; c++)
+        buffer.push_back((uint8_t) e.emg[c]);
+  }
+
+  events++;
+
+  if(buffer.size() >= RECORDER_CHUNK)
+    flush();
+}
+
+Recording::Recording()
+: offset(RECORDING_HEADER), last(0) {}
+
+bool Recording::isRecording(const std::string & path) {
+  FILE * f = fopen(path.c_str(), "rb");
+  if(f == NULL)
+    return false;
+
+  char magic[4];
+  bool match = fread(magic, 1, 4, f) == 4 && memcmp(magic, RECORDING_MAGIC, 4) == 0;
+  fclose(f);
+  return match;
+}
+
+bool Recording::open(const std::string & path) {
+  if(!file.open(path))
+    return false;
+
+  const uint8_t * d = file.data();
+  //each version only adds event types, version 1 has no raw IMU events,
+  //versions before 3 no EMG and before 4 no pairing
+  if(file.size() < RECORDING_HEADER || memcmp(d, RECORDING_MAGIC, 4) != 0 ||
+      d[4] < 1 || d[4] > RECORDING_VERSION) {
+    file.close();
+    return false;
+  }
+
+  rewind();
+  return true;
+}
+
+void Recording::close() {
+  file.close();
+}
+
+void Recording::rewind() {
+  const uint8_t * d = file.data();
+
+  last = 0;
+  for(int n = 0; n < 8; n++)
+    last |= (uint64_t) d[8 + n] << (8 * n);
+  offset = RECORDING_HEADER;
+}
+
+bool Recording::next(InputEvent & e) {
+  const uint8_t * d = file.data();
+  size_t size = file.size();
+
+  if(offset >= size)
+    return false;
+
+  size_t at = offset;
+  uint8_t tag = d[at++];
+
+  uint64_t zigzag = 0;
+  for(int shift = 0; ; shift += 7) {
+    if(at >= size || shift > 63)
+      return false;
+    uint8_t b = d[at++];
+    zigzag |= (uint64_t) (b & 0x7F) << shift;
+    if(!(b & 0x80))
+      break;
+  }
+  int64_t delta = (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+
+  e.timestamp = last + delta;
+  e.type = tag & 0x0F;
+  e.value = 0;
+  e.quat[0] = 1;
+  e.quat[1] = 0;
+  e.quat[2] = 0;
+  e.quat[3] = 0;
+  memset(e.emg, 0, sizeof(e.emg));
+
+  if(e.type == EVENT_ORIENTATION) {
+    //the dropped component is one of four, anything else is damage
+    int largest = tag >> 4;
+    if(largest > 3 || at + 6 > size)
+      return false;
+
+    float sum = 0;
+
+    for(int n = 0; n < 4; n++) {
+      if(n == largest)
+        continue;
+      int16_t v = (int16_t) (d[at] | (d[at + 1] << 8));
+      at += 2;
+      e.quat[n] = v / QUAT_SCALE;
+      sum += e.quat[n] * e.quat[n];
+    }
+    e.quat[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+  }
+  else if(e.type == EVENT_POSE || e.type == EVENT_ARM_SYNC) {
+    if(at + 1 > size)
+      return false;
+    e.value = d[at++];
+  }
+  else if(e.type == EVENT_GYROSCOPE || e.type == EVENT_ACCELEROMETER) {
+    if(at + 6 > size)
+      return false;
+
+    float scale = vectorScale(e.type);
+    e.quat[0] = 0;
+    for(int n = 1; n < 4; n++) {
+      int16_t v = (int16_t) (d[at] | (d[at + 1] << 8));
+      at += 2;
+      e.quat[n] = v / scale;
+    }
+  }
+  else if(e.type == EVENT_EMG) {
+    if(at + EMG_CHANNELS > size)
+      return false;
+
+    for(int c = 0; c < EMG_CHANNELS; c++)
+      e.emg[c] = (int8_t) d[at++];
+  }
+  else if(e.type >= EVENT_TYPES) {
+    return false;
+  }
+
+  offset = at;
+  last = e.timestamp;
+  return true;
+}
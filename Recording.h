@@ -0,0 +1,78 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Recording.h
+ Description:   Compact binary log of armband events, written while a
+                session runs and read back through a memory mapping.
+ *****************************************************************************/
+
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Input.h"
+#include "MappedFile.h"
+
+#ifndef RECORDING_H
+#define RECORDING_H
+
+//file layout, all little endian:
+//  header  "MYOR", version byte, 3 reserved bytes, uint64 first timestamp
+//  events  tag byte, zigzag varint timestamp delta, payload
+//the tag's low nibble is the event type, the high nibble is type specific.
+//orientation stores the three smallest quaternion components as int16 with
+//the dropped component's index in the tag, gyroscope and accelerometer
+//store x, y, z as int16 (version 2 on), EMG stores its eight channels as
+//int8 (version 3 on), pose and arm sync store one value byte, everything
+//else has no payload. Pairing is only recorded from version 4 on
+const char RECORDING_MAGIC[4] = {'M', 'Y', 'O', 'R'};
+const uint8_t RECORDING_VERSION = 4;
+const size_t RECORDING_HEADER = 16;
+
+class Recorder{
+  public:
+    Recorder();
+    ~Recorder();
+
+    bool open(const std::string & path);
+    void close();
+
+    //one thread at a time, events should arrive in timestamp order
+    void write(const InputEvent & e);
+
+    uint64_t count() const { return events; }
+
+  private:
+    void header(uint64_t timestamp);
+    void flush();
+
+    FILE * file;
+    std::vector<uint8_t> buffer;
+    bool first;
+    uint64_t last;
+    uint64_t events;
+};
+
+class Recording{
+  public:
+    Recording();
+
+    //false if path can't be mapped or isn't a recording
+    bool open(const std::string & path);
+    void close();
+
+    //next event in the file, false at the end or on a damaged record
+    bool next(InputEvent & e);
+    void rewind();
+
+    static bool isRecording(const std::string & path);
+
+  private:
+    MappedFile file;
+    size_t offset;
+    uint64_t last;
+};
+
+#endif /* RECORDING_H */
@@ -0,0 +1,90 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     RingBuffer.h
+ Description:   Lock free single producer / single consumer queue used to
+                hand data from one thread to another.
+ *****************************************************************************/
+
+
+#include <atomic>
+#include <new>
+#include <cstddef>
+#include <stdint.h>
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+//N must be a power of two, one thread may push and one other thread may pop
+template<typename T, unsigned int N>
+class RingBuffer{
+  static_assert((N & (N - 1)) == 0, "RingBuffer size must be a power of two");
+
+  public:
+    RingBuffer() : head(0), tail(0) {}
+
+    //producer side, false when full
+    bool push(const T & item) {
+      unsigned int h = head.load(std::memory_order_relaxed);
+      if(h - tail.load(std::memory_order_acquire) == N)
+        return false;
+
+      items[h & (N - 1)] = item;
+      head.store(h + 1, std::memory_order_release);
+      return true;
+    }
+
+    //consumer side, false when empty
+    bool pop(T & item) {
+      unsigned int t = tail.load(std::memory_order_relaxed);
+      if(t == head.load(std::memory_order_acquire))
+        return false;
+
+      item = items[t & (N - 1)];
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    //approximate when called from neither side
+    unsigned int size() const {
+      return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    unsigned int capacity() const {
+      return N;
+    }
+
+  private:
+    //keep the two indices on separate cache lines, padded rather than
+    //alignas so plain new still works before C++17. Only newAligned also
+    //keeps head off whatever sits in front of the ring
+    std::atomic<unsigned int> head;
+    char padHead[64 - sizeof(std::atomic<unsigned int>)];
+    std::atomic<unsigned int> tail;
+    char padTail[64 - sizeof(std::atomic<unsigned int>)];
+    T items[N];
+};
+
+const size_t CACHE_LINE = 64;
+
+//new before C++17 only promises alignof(max_align_t), these start the T on a
+//cache line. The pointer to free sits just in front of it
+template<typename T>
+T * newAligned() {
+  char * raw = new char[sizeof(T) + sizeof(char *) + CACHE_LINE - 1];
+  uintptr_t at = ((uintptr_t) raw + sizeof(char *) + CACHE_LINE - 1) & ~(uintptr_t) (CACHE_LINE - 1);
+  ((char **) at)[-1] = raw;
+  return new((void *) at) T;
+}
+
+template<typename T>
+void deleteAligned(T * p) {
+  if(p == NULL)
+    return;
+  char * raw = ((char **) p)[-1];
+  p->~T();
+  delete[] raw;
+}
+
+#endif /* RINGBUFFER_H */
@@ -0,0 +1,312 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Stroke.cpp
+ Description:   Thick line rasterizer, turns stroke segments and polylines
+                into capsules and fills them as horizontal spans.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "Stroke.h"
+
+#include <cmath>
+#include <algorithm>
+
+//std::floor/ceil are library calls without SSE4.1, these stay inline
+static inline int floorInt(float v) {
+  int i = (int) v;
+  return i > v ? i - 1 : i;
+}
+
+static inline int ceilInt(float v) {
+  int i = (int) v;
+  return i < v ? i + 1 : i;
+}
+
+void Stroke::segment(Canvas & canvas, float x0, float y0, float x1, float y1,
+    float radius, Uint32 color) {
+  runs.clear();
+  rasterize(canvas.extent(), x0, y0, radius, x1, y1, radius, 255);
+  fill(canvas, color);
+}
+
+void Stroke::polyline(Canvas & canvas, const std::vector<StrokePoint> & points,
+    Uint32 color, bool continued) {
+  trace(points, canvas.extent(), continued);
+  fill(canvas, color);
+}
+
+void Stroke::spans(const std::vector<StrokePoint> & points, int width, int height,
+    std::vector<SDL_Rect> & rects) {
+  SDL_Rect clip = {0, 0, width, height};
+  trace(points, clip, false);
+
+  rects.resize(runs.size());
+  for(size_t n = 0; n < runs.size(); n++) {
+    SDL_Rect r = {runs[n].left, runs[n].row, runs[n].right - runs[n].left + 1, 1};
+    rects[n] = r;
+  }
+}
+
+//runs covering a polyline, each pixel in exactly one
+void Stroke::trace(const std::vector<StrokePoint> & points, const SDL_Rect & clip,
+    bool continued) {
+  runs.clear();
+
+  if(points.size() == 1) {
+    const StrokePoint & p = points[0];
+    rasterize(clip, p.x, p.y, p.radius, p.x, p.y, p.radius, p.alpha);
+  }
+
+  for(size_t n = 1; n < points.size(); n++) {
+    const StrokePoint & a = points[n - 1];
+    const StrokePoint & b = points[n];
+    Uint8 alpha = continued && n == 1 ? 0 : b.alpha;
+    rasterize(clip, a.x, a.y, a.radius, b.x, b.y, b.radius, alpha);
+  }
+
+  //neighbouring capsules overlap at every joint
+  if(points.size() > 2)
+    merge();
+}
+
+//append the rows of one capsule to the span buffer
+void Stroke::rasterize(const SDL_Rect & clip, float x0, float y0, float r0,
+    float x1, float y1, float r1, Uint8 alpha) {
+  r0 = std::max(r0, 0.0f);
+  r1 = std::max(r1, 0.0f);
+  if(r0 <= 0 && r1 <= 0)
+    return;
+
+  //rows whose pixel centers can fall inside the capsule
+  int top = ceilInt(std::min(y0 - r0, y1 - r1) - 0.5f);
+  int bottom = floorInt(std::max(y0 + r0, y1 + r1) - 0.5f);
+
+  top = std::max(top, clip.y);
+  bottom = std::min(bottom, clip.y + clip.h - 1);
+
+  if(bottom < top)
+    return;
+
+  Capsule c;
+  prepare(c, x0, y0, r0, x1, y1, r1);
+
+  //(clamped so empty rows don't overflow the int conversion)
+  float low = clip.x - 1.0f;
+  float limit = clip.x + clip.w + 1.0f;
+
+  for(int row = top; row <= bottom; row++) {
+    float left, right;
+    span(c, row + 0.5f, left, right);
+
+    //pixel centers inside [left, right]
+    Run r;
+    r.row = row;
+    r.alpha = alpha;
+    r.left = ceilInt(std::min(std::max(left, low), limit) - 0.5f);
+    r.right = floorInt(std::min(std::max(right, low), limit) - 0.5f);
+
+    if(r.left <= r.right)
+      runs.push_back(r);
+  }
+}
+
+//bucket runs by row and join the ones that touch, so fill writes each pixel once
+void Stroke::merge() {
+  if(runs.empty())
+    return;
+
+  int top = runs[0].row;
+  int bottom = top;
+  for(size_t n = 1; n < runs.size(); n++) {
+    top = std::min(top, runs[n].row);
+    bottom = std::max(bottom, runs[n].row);
+  }
+
+  //counting sort on row, rows are bounded by the stroke's height
+  rowStart.assign(bottom - top + 2, 0);
+  for(size_t n = 0; n < runs.size(); n++)
+    rowStart[runs[n].row - top + 1]++;
+  for(size_t r = 1; r < rowStart.size(); r++)
+    rowStart[r] += rowStart[r - 1];
+
+  sorted.resize(runs.size());
+  for(size_t n = 0; n < runs.size(); n++)
+    sorted[rowStart[runs[n].row - top]++] = runs[n];
+
+  runs.clear();
+
+  //only a handful of runs share a row, insertion sort them by left edge
+  size_t first = 0;
+  while(first < sorted.size()) {
+    size_t last = first + 1;
+    bool uniform = sorted[first].alpha != 0;
+    while(last < sorted.size() && sorted[last].row == sorted[first].row) {
+      uniform &= sorted[last].alpha == sorted[first].alpha;
+      last++;
+    }
+
+    if(!uniform) {
+      flatten(first, last);
+      first = last;
+      continue;
+    }
+
+    for(size_t n = first + 1; n < last; n++) {
+      Run r = sorted[n];
+      size_t m = n;
+      for(; m > first && sorted[m - 1].left > r.left; m--)
+        sorted[m] = sorted[m - 1];
+      sorted[m] = r;
+    }
+
+    Run joined = sorted[first];
+    for(size_t n = first + 1; n < last; n++) {
+      if(sorted[n].left <= joined.right + 1) {
+        joined.right = std::max(joined.right, sorted[n].right);
+      }
+      else {
+        runs.push_back(joined);
+        joined = sorted[n];
+      }
+    }
+    runs.push_back(joined);
+
+    first = last;
+  }
+}
+
+//one row of runs with different alphas, split where coverage changes so each
+//piece takes the highest alpha over it, and nothing under a mask is kept
+void Stroke::flatten(size_t first, size_t last) {
+  edges.clear();
+  for(size_t n = first; n < last; n++) {
+    edges.push_back(sorted[n].left);
+    edges.push_back(sorted[n].right + 1);
+  }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  Run piece = sorted[first];
+  bool open = false;
+
+  for(size_t e = 0; e + 1 < edges.size(); e++) {
+    int x = edges[e];
+    int alpha = -1;
+    bool masked = false;
+
+    for(size_t n = first; n < last; n++) {
+      const Run & r = sorted[n];
+      if(r.left > x || r.right < x)
+        continue;
+      if(r.alpha == 0)
+        masked = true;
+      alpha = std::max(alpha, (int) r.alpha);
+    }
+
+    if(masked || alpha < 0) {
+      if(open)
+        runs.push_back(piece);
+      open = false;
+      continue;
+    }
+
+    if(open && piece.alpha == alpha && piece.right + 1 == x) {
+      piece.right = edges[e + 1] - 1;
+      continue;
+    }
+
+    if(open)
+      runs.push_back(piece);
+    piece.left = x;
+    piece.right = edges[e + 1] - 1;
+    piece.alpha = (Uint8) alpha;
+    open = true;
+  }
+
+  if(open)
+    runs.push_back(piece);
+}
+
+//per segment constants so the row loop is only multiplies and adds
+void Stroke::prepare(Capsule & c, float x0, float y0, float r0, float x1, float y1, float r1) {
+  c.x0 = x0;
+  c.y0 = y0;
+  c.r0 = r0;
+  c.x1 = x1;
+  c.y1 = y1;
+  c.r1 = r1;
+
+  float dx = x1 - x0;
+  float dy = y1 - y0;
+  float len = std::sqrt(dx * dx + dy * dy);
+
+  //one end circle inside the other leaves nothing between them
+  c.body = len > std::fabs(r1 - r0);
+  if(!c.body)
+    return;
+
+  //both outer tangents have normals m with m . (x1 - x0) = (r0 - r1) / len,
+  //touching circle i at its center + r_i m
+  float ux = dx / len, uy = dy / len;
+  float along = (r0 - r1) / len;
+  float across = std::sqrt(1 - along * along);
+
+  float mx[2] = {along * ux - across * uy, along * ux + across * uy};
+  float my[2] = {along * uy + across * ux, along * uy - across * ux};
+
+  for(int e = 0; e < 2; e++) {
+    float ax = x0 + r0 * mx[e], ay = y0 + r0 * my[e];
+    float bx = x1 + r1 * mx[e], by = y1 + r1 * my[e];
+
+    c.edgeX[e] = ay < by ? ax : bx;
+    c.edgeTop[e] = std::min(ay, by);
+    c.edgeBottom[e] = std::max(ay, by);
+    c.edgeSlope[e] = by != ay ? (bx - ax) / (by - ay) : 0;
+  }
+}
+
+//horizontal extent of the capsule on the line y = cy, left > right if empty
+inline void Stroke::span(const Capsule & c, float cy, float & left, float & right) {
+  left = 1e30f;
+  right = -1e30f;
+
+  //end caps
+  float dy = cy - c.y0;
+  float r2 = c.r0 * c.r0;
+  if(dy * dy <= r2) {
+    float h = std::sqrt(r2 - dy * dy);
+    left = c.x0 - h;
+    right = c.x0 + h;
+  }
+
+  float ey = cy - c.y1;
+  r2 = c.r1 * c.r1;
+  if(ey * ey <= r2) {
+    float h = std::sqrt(r2 - ey * ey);
+    left = std::min(left, c.x1 - h);
+    right = std::max(right, c.x1 + h);
+  }
+
+  if(!c.body)
+    return;
+
+  //the quad's other two sides are chords of the end circles, so only where
+  //the row crosses the tangents can widen the span
+  for(int e = 0; e < 2; e++) {
+    if(cy < c.edgeTop[e] || cy > c.edgeBottom[e] || c.edgeTop[e] == c.edgeBottom[e])
+      continue;
+
+    float x = c.edgeX[e] + c.edgeSlope[e] * (cy - c.edgeTop[e]);
+    left = std::min(left, x);
+    right = std::max(right, x);
+  }
+}
+
+//write the buffered spans, one store per covered pixel
+void Stroke::fill(Canvas & canvas, Uint32 color) {
+  for(size_t n = 0; n < runs.size(); n++)
+    if(runs[n].alpha != 0)
+      canvas.fillSpan(runs[n].row, runs[n].left, runs[n].right, color, runs[n].alpha);
+}
@@ -0,0 +1,83 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Stroke.h
+ Description:   Thick line rasterizer, turns stroke segments and polylines
+                into capsules and fills them as horizontal spans.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include "Canvas.h"
+
+#ifndef STROKE_H
+#define STROKE_H
+
+//one mapped input sample along a stroke
+struct StrokePoint {
+  float x, y;
+  float radius;
+  Uint8 alpha;    //255 paints over the canvas, less blends into it
+
+  StrokePoint() : x(0), y(0), radius(0), alpha(255) {}
+  StrokePoint(float x, float y, float radius, Uint8 alpha = 255)
+  : x(x), y(y), radius(radius), alpha(alpha) {}
+};
+
+class Stroke{
+  public:
+    //fill every pixel within radius of segment (x0, y0) - (x1, y1) exactly once
+    void segment(Canvas & canvas, float x0, float y0, float x1, float y1,
+        float radius, Uint32 color);
+
+    //fill the union of the capsules between consecutive points, each pixel
+    //once at the highest alpha covering it. Segments taper from the radius
+    //of the point they start on to the one they end on. continued means the
+    //first segment is already on the canvas and only pixels outside it are
+    //painted, so a stroke drawn over several frames blends each pixel once
+    void polyline(Canvas & canvas, const std::vector<StrokePoint> & points,
+        Uint32 color, bool continued = false);
+
+    //the same pixels as polyline as one pixel high rects clipped to
+    //width x height, for drawing straight to the renderer
+    void spans(const std::vector<StrokePoint> & points, int width, int height,
+        std::vector<SDL_Rect> & rects);
+
+  private:
+    //two end circles and the quad between their outer tangents
+    struct Capsule {
+      float x0, y0, r0;
+      float x1, y1, r1;
+      bool body;
+      float edgeX[2];                 //each tangent's x at its top
+      float edgeTop[2], edgeBottom[2];
+      float edgeSlope[2];             //dx / dy
+    };
+
+    //covered pixels [left, right] of one row, alpha 0 masks them out
+    struct Run {
+      int row;
+      int left, right;
+      Uint8 alpha;
+    };
+
+    void prepare(Capsule & c, float x0, float y0, float r0, float x1, float y1, float r1);
+    void span(const Capsule & c, float cy, float & left, float & right);
+    void trace(const std::vector<StrokePoint> & points, const SDL_Rect & clip,
+        bool continued);
+    void rasterize(const SDL_Rect & clip, float x0, float y0, float r0,
+        float x1, float y1, float r1, Uint8 alpha);
+    void merge();
+    void flatten(size_t first, size_t last);
+    void fill(Canvas & canvas, Uint32 color);
+
+    //span buffer shared by every segment of a call, reused between calls
+    std::vector<Run> runs;
+    std::vector<Run> sorted;
+    std::vector<int> rowStart;
+    std::vector<int> edges;
+};
+
+#endif /* STROKE_H */
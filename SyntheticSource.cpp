@@ -0,0 +1,243 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     SyntheticSource.cpp
+ Description:   Deterministic stand-in for the armband, generates orientation
+                and pose streams from a motion pattern, plus the raw IMU and
+                EMG behind them.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "SyntheticSource.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <algorithm>
+
+//how far the patterns swing, roughly the whole window at X_SENS / Y_SENS
+const float SWING_YAW = 0.45f;
+const float SWING_PITCH = 0.4f;
+
+//constant gyroscope error the fusion has to learn away, deg/s
+const float GYRO_BIAS = 0.5f;
+
+//how long the double tap, spread and first sync events last
+const double TAP_TIME = 0.1;
+const double SPREAD_TIME = 0.2;
+
+//muscles fire this long before the armband's own classifier reports the pose
+const double EMG_LEAD = 0.15;
+
+//EMG amplitude of the flexor (0 to 3) and extensor (4 to 7) channels per pose
+const float EMG_FLEXOR[POSE_TYPES] = {30, 20, 10, 2};
+const float EMG_EXTENSOR[POSE_TYPES] = {10, 20, 30, 2};
+
+//a held fist squeezes harder and softer by this much, this often
+const float GRIP_SWING = 0.6f;
+const double GRIP_RATE = 0.5;
+
+SyntheticSource::SyntheticSource(const SyntheticConfig & config)
+: config(config), state(config.seed ? config.seed : 1), emgState(state * 2654435761u | 1), emgSent(0),
+  walkYaw(0), walkPitch(0) {}
+
+SyntheticSource::~SyntheticSource() {
+  stop();
+}
+
+bool SyntheticSource::motion(const std::string & pattern, double t, float & yaw, float & pitch) {
+  if(pattern == "still") {
+    yaw = 0;
+    pitch = 0;
+  }
+  else if(pattern == "circle") {
+    yaw = SWING_YAW * std::sin(2 * M_PI * 0.25 * t);
+    pitch = SWING_PITCH * std::cos(2 * M_PI * 0.25 * t);
+  }
+  else if(pattern == "lissajous") {
+    yaw = SWING_YAW * std::sin(2 * M_PI * 0.3 * t);
+    pitch = SWING_PITCH * std::sin(2 * M_PI * 0.2 * t);
+  }
+  else if(pattern == "pauses") {
+    //the circle, holding still for 4 s after every 4 s of motion
+    double moving = std::floor(t / 8) * 4 + std::min(std::fmod(t, 8.0), 4.0);
+    yaw = SWING_YAW * std::sin(2 * M_PI * 0.25 * moving);
+    pitch = SWING_PITCH * std::cos(2 * M_PI * 0.25 * moving);
+  }
+  else if(pattern == "zigzag") {
+    //fast triangle wave across, slow one down
+    double across = std::fmod(t * 1.5, 2.0);
+    double down = std::fmod(t * 0.1, 2.0);
+    yaw = SWING_YAW * (float) (across < 1 ? 2 * across - 1 : 3 - 2 * across);
+    pitch = SWING_PITCH * (float) (down < 1 ? 2 * down - 1 : 3 - 2 * down);
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+//xorshift, the same seed always gives the same session
+static float xorshift(unsigned int & state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return (state & 0xFFFFFF) / (float) 0x800000 - 1.0f;
+}
+
+float SyntheticSource::random() {
+  return xorshift(state);
+}
+
+int SyntheticSource::poseAt(double t) {
+  if(t < TAP_TIME)
+    return POSE_TAP;
+
+  if(config.clearEvery > 0 && t >= config.clearEvery &&
+      std::fmod(t, config.clearEvery) < SPREAD_TIME)
+    return POSE_SPREAD;
+
+  if(std::fmod(t - TAP_TIME, config.strokeOn + config.strokeOff) < config.strokeOn)
+    return POSE_FIST;
+
+  return POSE_OTHER;
+}
+
+//Euler angles to the quaternion the armband would report
+static void toQuat(float yaw, float pitch, float roll, float * q) {
+  float cr = std::cos(roll / 2), sr = std::sin(roll / 2);
+  float cp = std::cos(pitch / 2), sp = std::sin(pitch / 2);
+  float cy = std::cos(yaw / 2), sy = std::sin(yaw / 2);
+
+  q[0] = cr * cp * cy + sr * sp * sy;
+  q[1] = sr * cp * cy - cr * sp * sy;
+  q[2] = cr * sp * cy + sr * cp * sy;
+  q[3] = cr * cp * sy - sr * sp * cy;
+}
+
+//raw readings for the noiseless motion from one orientation to the next
+bool SyntheticSource::imu(uint64_t timestamp, const float * from, const float * to, float dt) {
+  const float * q = to;
+
+  //gravity in the band's frame, the third row of its rotation
+  InputEvent accel = {timestamp, EVENT_ACCELEROMETER, 0, {0,
+    2 * (q[1] * q[3] - q[0] * q[2]) + 0.01f * random(),
+    2 * (q[2] * q[3] + q[0] * q[1]) + 0.01f * random(),
+    1 - 2 * (q[1] * q[1] + q[2] * q[2]) + 0.01f * random()}};
+
+  //body rate, 2 * vector part of conj(from) * to over dt
+  const float * a = from;
+  const float * b = to;
+  float w = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+  float k = (w < 0 ? -2.0f : 2.0f) / dt * (float) (180 / M_PI);
+  float jitter = config.noise * (float) (180 / M_PI) * 10;
+
+  InputEvent gyro = {timestamp, EVENT_GYROSCOPE, 0, {0,
+    k * (a[0] * b[1] - a[1] * b[0] - a[2] * b[3] + a[3] * b[2]) + jitter * random(),
+    k * (a[0] * b[2] + a[1] * b[3] - a[2] * b[0] - a[3] * b[1]) + jitter * random(),
+    k * (a[0] * b[3] - a[1] * b[2] + a[2] * b[1] - a[3] * b[0]) + jitter * random() + GYRO_BIAS}};
+
+  return pushWait(accel) && pushWait(gyro);
+}
+
+//every EMG sample due by t, noise scaled by how hard the pose ahead works
+//each muscle group
+bool SyntheticSource::emg(double t) {
+  while(emgSent / (double) config.emgRate <= t) {
+    double at = emgSent / (double) config.emgRate;
+    emgSent++;
+
+    int pose = poseAt(at + EMG_LEAD);
+    InputEvent e = {(uint64_t) (at * 1000000.0), EVENT_EMG, 0, {1, 0, 0, 0}};
+
+    float grip = 1;
+    if(pose == POSE_FIST)
+      grip += GRIP_SWING * (float) std::sin(2 * M_PI * GRIP_RATE * at);
+
+    for(int c = 0; c < EMG_CHANNELS; c++) {
+      float amplitude = grip * (c < EMG_CHANNELS / 2 ? EMG_FLEXOR[pose] : EMG_EXTENSOR[pose]);
+      //three uniforms add up to about a unit normal
+      float v = amplitude * (xorshift(emgState) + xorshift(emgState) + xorshift(emgState));
+      e.emg[c] = (int8_t) std::max(-127.0f, std::min(127.0f, v));
+    }
+
+    if(!pushWait(e))
+      return false;
+  }
+  return true;
+}
+
+void SyntheticSource::run() {
+  InputEvent pair = {0, EVENT_PAIR, 0, {1, 0, 0, 0}};
+  InputEvent sync = {0, EVENT_ARM_SYNC, 0, {1, 0, 0, 0}};
+  InputEvent unlock = {0, EVENT_UNLOCK, 0, {1, 0, 0, 0}};
+  pushWait(pair);
+  pushWait(sync);
+  pushWait(unlock);
+
+  int pose = -1;
+
+  //IMU ticks per orientation sample, the loop runs at the faster of the two
+  int every = config.imuRate > 0 ? std::max(1, (int) (config.imuRate / config.rate + 0.5f)) : 1;
+  double step = 1.0 / ((double) config.rate * every);
+  float walkStep = 0.02f / std::sqrt((float) every);
+  float last[4];
+
+  for(uint64_t n = 0; running; n++) {
+    double t = n / ((double) config.rate * every);
+    if(config.duration > 0 && t > config.duration)
+      break;
+
+    uint64_t timestamp = (uint64_t) (t * 1000000.0);
+    pace(timestamp, config.speed);
+
+    float yaw, pitch;
+    if(!motion(config.pattern, t, yaw, pitch)) {
+      //bounded random walk
+      walkYaw += walkStep * random();
+      walkPitch += walkStep * random();
+      walkYaw = std::max(-SWING_YAW, std::min(SWING_YAW, walkYaw));
+      walkPitch = std::max(-SWING_PITCH, std::min(SWING_PITCH, walkPitch));
+      yaw = walkYaw;
+      pitch = walkPitch;
+    }
+
+    //slow wrist twist so the stroke width changes too
+    float roll = (float) (M_PI / 3 + 0.3 * std::sin(2 * M_PI * 0.1 * t));
+
+    float truth[4];
+    toQuat(yaw, pitch, roll, truth);
+
+    if(config.emgRate > 0 && !emg(t))
+      break;
+
+    if(n % every == 0) {
+      yaw += (float) (config.yawDrift * t);
+      yaw += config.noise * random();
+      pitch += config.noise * random();
+      roll += config.noise * random();
+
+      InputEvent e = {timestamp, EVENT_ORIENTATION, 0, {1, 0, 0, 0}};
+      toQuat(yaw, pitch, roll, e.quat);
+      if(!pushWait(e))
+        break;
+    }
+
+    if(config.imuRate > 0 && !imu(timestamp, n > 0 ? last : truth, truth, (float) step))
+      break;
+
+    for(int c = 0; c < 4; c++)
+      last[c] = truth[c];
+
+    if(n % every != 0)
+      continue;
+
+    int next = poseAt(t);
+    if(next != pose) {
+      InputEvent p = {timestamp, EVENT_POSE, next, {1, 0, 0, 0}};
+      if(!pushWait(p))
+        break;
+      pose = next;
+    }
+  }
+}
@@ -0,0 +1,61 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     SyntheticSource.h
+ Description:   Deterministic stand-in for the armband, generates orientation
+                and pose streams from a motion pattern, plus the raw IMU and
+                EMG behind them.
+ *****************************************************************************/
+
+
+#include <string>
+#include "InputSource.h"
+
+#ifndef SYNTHETICSOURCE_H
+#define SYNTHETICSOURCE_H
+
+struct SyntheticConfig {
+  std::string pattern;  //still, circle, lissajous, pauses, zigzag or walk
+  float rate;           //orientation samples per second
+  float imuRate;        //raw gyroscope / accelerometer samples per second, 0 sends none
+  float emgRate;        //raw EMG samples per second, 0 sends none
+  float speed;          //playback speed, 0 generates as fast as possible
+  float duration;       //seconds of generated time, 0 runs until stopped
+  float noise;          //jitter added to every angle, radians
+  float yawDrift;       //heading error the armband builds up, rad/s
+  float strokeOn;       //seconds the fist is held per stroke
+  float strokeOff;      //seconds between strokes
+  float clearEvery;     //seconds between fingers spread poses, 0 never clears
+  unsigned int seed;
+
+  SyntheticConfig()
+  : pattern("circle"), rate(50), imuRate(0), emgRate(0), speed(1), duration(0), noise(0.002f), yawDrift(0),
+    strokeOn(3), strokeOff(1), clearEvery(0), seed(1) {}
+};
+
+class SyntheticSource : public InputSource {
+  public:
+    SyntheticSource(const SyntheticConfig & config);
+    ~SyntheticSource();
+
+    //pattern angles at time t, radians
+    static bool motion(const std::string & pattern, double t, float & yaw, float & pitch);
+
+  protected:
+    void run();
+
+  private:
+    int poseAt(double t);
+    bool imu(uint64_t timestamp, const float * from, const float * to, float dt);
+    bool emg(double t);
+    float random();
+
+    SyntheticConfig config;
+    unsigned int state;
+    unsigned int emgState;  //own stream so EMG leaves the other events as they were
+    uint64_t emgSent;
+    float walkYaw, walkPitch;
+};
+
+#endif /* SYNTHETICSOURCE_H */
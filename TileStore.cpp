@@ -0,0 +1,298 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     TileStore.cpp
+ Description:   Canvas tiles kept in one sparse file, each mapped only while
+                it's copied in or out. Writes are queued and done by a
+                background thread.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "TileStore.h"
+
+#include <cstdio>
+#include <cstring>
+
+//gens start after this much header
+const size_t TILESTORE_HEADER = 64;
+
+TileStore::TileStore()
+: loads(0), saves(0), failed(0), header(NULL), gens(NULL), indexBytes(0), tiles(0),
+  tileBytes(0), writing(NULL), lock(SDL_CreateMutex()), work(NULL), room(NULL),
+  handle(NULL), running(false) {}
+
+TileStore::~TileStore() {
+  close();
+  SDL_DestroyMutex(lock);
+}
+
+bool TileStore::open(const std::string & path, int side, int tileSize, Uint32 format) {
+  close();
+
+  tileBytes = (size_t) tileSize * tileSize * 4;
+  uint64_t cells = (side + tileSize - 1) / tileSize;
+  uint64_t index = TILESTORE_HEADER + cells * cells * 4;
+  uint64_t first = (index + tileBytes - 1) / tileBytes * tileBytes;
+
+  if(!file.edit(path, first + cells * cells * tileBytes) || file.fileSize() < TILESTORE_HEADER) {
+    printf("Canvas file %s could not be opened!\n", path.c_str());
+    file.close();
+    return false;
+  }
+
+  //a new file is all zeros, give it a header
+  header = (Header *) file.view(0, TILESTORE_HEADER);
+  if(header == NULL) {
+    printf("Canvas file %s could not be mapped!\n", path.c_str());
+    file.close();
+    return false;
+  }
+
+  const char none[4] = {0, 0, 0, 0};
+  if(memcmp(header->magic, none, 4) == 0) {
+    memcpy(header->magic, TILESTORE_MAGIC, 4);
+    header->version = TILESTORE_VERSION;
+    header->tileSize = tileSize;
+    header->format = format;
+    header->cols = (int32_t) cells;
+    header->rows = (int32_t) cells;
+    header->left = -header->cols / 2;
+    header->top = -header->rows / 2;
+    header->epoch = 1;
+  }
+
+  const char * problem = NULL;
+  if(memcmp(header->magic, TILESTORE_MAGIC, 4) != 0 || header->version != TILESTORE_VERSION)
+    problem = "isn't a canvas";
+  else if(header->tileSize != tileSize || header->format != format)
+    problem = "was drawn with another tile size or pixel format";
+
+  if(problem == NULL) {
+    cells = (uint64_t) header->cols * header->rows;
+    index = TILESTORE_HEADER + cells * 4;
+    first = (index + tileBytes - 1) / tileBytes * tileBytes;
+    if(file.fileSize() < first + cells * tileBytes)
+      problem = "is cut short";
+  }
+
+  file.unview((uint8_t *) header, TILESTORE_HEADER);
+  header = NULL;
+
+  if(problem != NULL) {
+    printf("Canvas file %s %s\n", path.c_str(), problem);
+    file.close();
+    return false;
+  }
+
+  //header and gens stay mapped, tiles are only mapped while copied
+  indexBytes = (size_t) index;
+  tiles = first;
+  uint8_t * base = file.view(0, indexBytes);
+  if(base == NULL) {
+    printf("Canvas file %s could not be mapped!\n", path.c_str());
+    file.close();
+    return false;
+  }
+  header = (Header *) base;
+  gens = (uint32_t *) (base + TILESTORE_HEADER);
+
+  for(int n = 0; n < TILESTORE_QUEUE; n++) {
+    Writeback * w = new Writeback;
+    w->pixels.resize(tileSize * tileSize);
+    all.push_back(w);
+    idle.push_back(w);
+  }
+
+  work = SDL_CreateSemaphore(0);
+  room = SDL_CreateSemaphore(TILESTORE_QUEUE);
+  running = true;
+  handle = SDL_CreateThread(thread, "tiles", this);
+  if(handle == NULL) {
+    printf("Canvas writer thread failed! SDL_Error: %s\n", SDL_GetError());
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void TileStore::close() {
+  if(handle != NULL) {
+    //the writer empties the queue before it stops
+    running = false;
+    SDL_SemPost(work);
+    SDL_WaitThread(handle, NULL);
+    handle = NULL;
+  }
+
+  SDL_DestroySemaphore(work);
+  SDL_DestroySemaphore(room);
+  work = NULL;
+  room = NULL;
+
+  for(size_t n = 0; n < all.size(); n++)
+    delete all[n];
+  all.clear();
+  idle.clear();
+  pending.clear();
+
+  if(header != NULL)
+    file.unview((uint8_t *) header, indexBytes);
+  header = NULL;
+  gens = NULL;
+  file.close();
+}
+
+SDL_Rect TileStore::extent() {
+  int size = header->tileSize;
+  SDL_Rect r = {header->left * size, header->top * size, header->cols * size, header->rows * size};
+  return r;
+}
+
+bool TileStore::inside(int tx, int ty) {
+  return tx >= header->left && tx < header->left + header->cols &&
+      ty >= header->top && ty < header->top + header->rows;
+}
+
+size_t TileStore::index(int tx, int ty) {
+  return (size_t) (ty - header->top) * header->cols + (tx - header->left);
+}
+
+//newest write of tile tx, ty not yet in the file, lock held
+const TileStore::Writeback * TileStore::queued(int tx, int ty) {
+  for(size_t n = pending.size(); n-- > 0; )
+    if(pending[n]->tx == tx && pending[n]->ty == ty)
+      return pending[n];
+  if(writing != NULL && writing->tx == tx && writing->ty == ty)
+    return writing;
+  return NULL;
+}
+
+bool TileStore::has(int tx, int ty, unsigned int gen) {
+  if(!inside(tx, ty))
+    return false;
+
+  SDL_LockMutex(lock);
+  const Writeback * w = queued(tx, ty);
+  bool found = w != NULL ? w->gen == gen : gens[index(tx, ty)] == gen;
+  SDL_UnlockMutex(lock);
+
+  return found;
+}
+
+bool TileStore::load(int tx, int ty, unsigned int gen, Uint32 * pixels) {
+  if(!inside(tx, ty))
+    return false;
+
+  //the writer only reads a queued write, copying from it too is safe
+  SDL_LockMutex(lock);
+  const Writeback * w = queued(tx, ty);
+  bool found = w != NULL && w->gen == gen;
+  if(found)
+    memcpy(pixels, &w->pixels[0], tileBytes);
+  SDL_UnlockMutex(lock);
+
+  if(w != NULL) {
+    loads += found;
+    return found;
+  }
+
+  //nothing queued, whatever the file has is the newest
+  size_t n = index(tx, ty);
+  if(gens[n] != gen)
+    return false;
+
+  uint8_t * at = file.view(tiles + (uint64_t) n * tileBytes, tileBytes);
+  if(at == NULL)
+    return false;
+  memcpy(pixels, at, tileBytes);
+  file.unview(at, tileBytes);
+
+  loads++;
+  return true;
+}
+
+void TileStore::save(int tx, int ty, unsigned int gen, const Uint32 * pixels) {
+  if(!inside(tx, ty))
+    return;
+
+  //a full queue is the one place painting waits on the disk
+  SDL_SemWait(room);
+
+  SDL_LockMutex(lock);
+  Writeback * w = idle.back();
+  idle.pop_back();
+  SDL_UnlockMutex(lock);
+
+  w->tx = tx;
+  w->ty = ty;
+  w->gen = gen;
+  memcpy(&w->pixels[0], pixels, tileBytes);
+
+  SDL_LockMutex(lock);
+  pending.push_back(w);
+  SDL_UnlockMutex(lock);
+  SDL_SemPost(work);
+
+  saves++;
+}
+
+void TileStore::drain() {
+  if(handle == NULL)
+    return;
+
+  //every buffer back means nothing is queued or being written
+  for(int n = 0; n < TILESTORE_QUEUE; n++)
+    SDL_SemWait(room);
+  for(int n = 0; n < TILESTORE_QUEUE; n++)
+    SDL_SemPost(room);
+}
+
+size_t TileStore::bytes() {
+  return all.size() * tileBytes;
+}
+
+//writer thread, the pixels go in before the gen that makes them count
+void TileStore::write(const Writeback & w) {
+  size_t n = index(w.tx, w.ty);
+
+  uint8_t * at = file.view(tiles + (uint64_t) n * tileBytes, tileBytes);
+  if(at == NULL) {
+    failed++;
+    return;
+  }
+  memcpy(at, &w.pixels[0], tileBytes);
+  file.unview(at, tileBytes);
+
+  gens[n] = w.gen;
+}
+
+int SDLCALL TileStore::thread(void * data) {
+  TileStore * self = (TileStore *) data;
+
+  while(true) {
+    SDL_SemWait(self->work);
+
+    SDL_LockMutex(self->lock);
+    if(self->pending.empty()) {
+      SDL_UnlockMutex(self->lock);
+      if(!self->running)
+        break;
+      continue;
+    }
+    Writeback * w = self->pending.front();
+    self->pending.pop_front();
+    self->writing = w;
+    SDL_UnlockMutex(self->lock);
+
+    self->write(*w);
+
+    SDL_LockMutex(self->lock);
+    self->writing = NULL;
+    self->idle.push_back(w);
+    SDL_UnlockMutex(self->lock);
+    SDL_SemPost(self->room);
+  }
+  return 0;
+}
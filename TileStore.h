@@ -0,0 +1,119 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     TileStore.h
+ Description:   Canvas tiles kept in one sparse file, each mapped only while
+                it's copied in or out. Writes are queued and done by a
+                background thread.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include "MappedFile.h"
+
+#ifndef TILESTORE_H
+#define TILESTORE_H
+
+//file layout, native endian:
+//  header  "MYOC", version byte, 3 reserved bytes, then int32 tile size,
+//          pixel format, left and top tile, columns, rows and clear epoch
+//  gens    uint32 per tile, the epoch it was last written in, 0 for never
+//  tiles   TILE_SIZE^2 pixels per tile row by row, starting on a multiple
+//          of a tile's size
+const char TILESTORE_MAGIC[4] = {'M', 'Y', 'O', 'C'};
+const uint8_t TILESTORE_VERSION = 1;
+
+//writes queued before save() waits for the writer to catch up
+const int TILESTORE_QUEUE = 32;
+
+class TileStore{
+  public:
+    TileStore();
+    ~TileStore();
+
+    //opens path, or creates it side x side pixels around the origin. tileSize
+    //and format have to match what the file was made with
+    bool open(const std::string & path, int side, int tileSize, Uint32 format);
+
+    //waits for queued writes
+    void close();
+
+    bool isOpen() { return gens != NULL; }
+
+    //world pixels the file has room for
+    SDL_Rect extent();
+
+    //tiles from before the last clear read as background
+    unsigned int epoch() { return header->epoch; }
+    void setEpoch(unsigned int e) { header->epoch = e; }
+
+    //main thread. Whether tile tx, ty was painted in epoch gen, and if so
+    //its pixels, newest queued write first
+    bool has(int tx, int ty, unsigned int gen);
+    bool load(int tx, int ty, unsigned int gen, Uint32 * pixels);
+
+    //main thread, copies the pixels and returns before they're written
+    void save(int tx, int ty, unsigned int gen, const Uint32 * pixels);
+
+    //until every queued write is in the file
+    void drain();
+
+    //memory held for queued writes
+    size_t bytes();
+
+    unsigned int loads;
+    unsigned int saves;
+    std::atomic<unsigned int> failed;   //writes that couldn't map their tile
+
+  private:
+    struct Header {
+      char magic[4];
+      uint8_t version;
+      uint8_t reserved[3];
+      int32_t tileSize;
+      uint32_t format;
+      int32_t left, top;
+      int32_t cols, rows;
+      uint32_t epoch;
+    };
+
+    struct Writeback {
+      int tx, ty;
+      unsigned int gen;
+      std::vector<Uint32> pixels;
+    };
+
+    static int SDLCALL thread(void * data);
+
+    bool inside(int tx, int ty);
+    size_t index(int tx, int ty);
+    const Writeback * queued(int tx, int ty);
+    void write(const Writeback & w);
+
+    MappedFile file;
+    Header * header;
+    uint32_t * gens;
+    size_t indexBytes;    //header and gens, mapped the whole time
+    uint64_t tiles;       //offset of the first tile
+    size_t tileBytes;
+
+    //writes waiting, oldest first, and the one being written
+    std::deque<Writeback *> pending;
+    Writeback * writing;
+    std::vector<Writeback *> idle;
+    std::vector<Writeback *> all;
+
+    SDL_mutex * lock;
+    SDL_sem * work;       //one post per queued write
+    SDL_sem * room;       //free write buffers
+    SDL_Thread * handle;
+    std::atomic<bool> running;
+};
+
+#endif /* TILESTORE_H */
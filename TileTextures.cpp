@@ -0,0 +1,153 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     TileTextures.cpp
+ Description:   Small streaming textures for the painted canvas tiles in
+                view, reused least recently drawn first and only uploaded
+                again when their tile changes.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "TileTextures.h"
+
+#include <cstdio>
+
+static uint64_t key(int tx, int ty) {
+  return ((uint64_t) (Uint32) ty << 32) | (Uint32) tx;
+}
+
+TileTextures::TileTextures()
+: renderer(NULL), format(0), limit(0), newest(NULL), oldest(NULL), frame(0) {}
+
+TileTextures::~TileTextures() {
+  free();
+}
+
+void TileTextures::init(SDL_Renderer * to, Uint32 pixelFormat, int count) {
+  free();
+  renderer = to;
+  format = pixelFormat;
+  limit = count;
+}
+
+void TileTextures::free() {
+  for(size_t n = 0; n < all.size(); n++) {
+    SDL_DestroyTexture(all[n]->texture);
+    delete all[n];
+  }
+  all.clear();
+  slots.clear();
+  copies.clear();
+  newest = NULL;
+  oldest = NULL;
+}
+
+void TileTextures::unlink(Slot * s) {
+  (s->newer != NULL ? s->newer->older : newest) = s->older;
+  (s->older != NULL ? s->older->newer : oldest) = s->newer;
+}
+
+void TileTextures::touch(Slot * s) {
+  if(s == newest)
+    return;
+
+  unlink(s);
+  s->newer = NULL;
+  s->older = newest;
+  (newest != NULL ? newest->newer : oldest) = s;
+  newest = s;
+}
+
+//a texture for tile tx, ty, new while under the limit and after that the
+//one drawn longest ago. NULL when every one is in view already
+TileTextures::Slot * TileTextures::acquire(int tx, int ty) {
+  Slot * s = NULL;
+
+  if((int) all.size() < limit) {
+    SDL_Texture * texture = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_STREAMING,
+        TILE_SIZE, TILE_SIZE);
+    if(texture != NULL) {
+      //tiles are opaque and never overlap
+      SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+
+      s = new Slot;
+      s->texture = texture;
+      s->newer = NULL;
+      s->older = NULL;
+      all.push_back(s);
+    }
+    else if(all.empty()) {
+      printf("Tile texture could not be created! SDL Error: %s\n", SDL_GetError());
+    }
+  }
+
+  if(s == NULL) {
+    s = oldest;
+    if(s == NULL || s->frame == frame)
+      return NULL;
+    unlink(s);
+    slots.erase(key(s->tx, s->ty));
+  }
+
+  s->tx = tx;
+  s->ty = ty;
+  s->version = 0;
+  s->newer = NULL;
+  s->older = newest;
+  (newest != NULL ? newest->newer : oldest) = s;
+  newest = s;
+  slots[key(tx, ty)] = s;
+
+  return s;
+}
+
+int TileTextures::update(Canvas & canvas) {
+  int area = 0;
+  frame++;
+  copies.clear();
+
+  int left = canvas.viewX(), top = canvas.viewY();
+  int tx0 = Canvas::tileOf(left), tx1 = Canvas::tileOf(left + canvas.width() - 1);
+  int ty0 = Canvas::tileOf(top), ty1 = Canvas::tileOf(top + canvas.height() - 1);
+
+  for(int ty = ty0; ty <= ty1; ty++) {
+    for(int tx = tx0; tx <= tx1; tx++) {
+      //background is the cleared renderer
+      Uint64 version;
+      const Uint32 * pixels = canvas.tile(tx, ty, version);
+      if(pixels == NULL)
+        continue;
+
+      Slot * s;
+      std::unordered_map<uint64_t, Slot *>::iterator it = slots.find(key(tx, ty));
+      if(it != slots.end()) {
+        s = it->second;
+        touch(s);
+      }
+      else {
+        s = acquire(tx, ty);
+        if(s == NULL)
+          continue;
+      }
+
+      if(s->version != version) {
+        SDL_UpdateTexture(s->texture, NULL, pixels, TILE_SIZE * 4);
+        s->version = version;
+        area += TILE_SIZE * TILE_SIZE;
+      }
+      s->frame = frame;
+
+      Copy c = {s->texture, {tx * TILE_SIZE - left, ty * TILE_SIZE - top, TILE_SIZE, TILE_SIZE}};
+      copies.push_back(c);
+    }
+  }
+
+  canvas.drawn();
+  return area;
+}
+
+void TileTextures::draw() {
+  for(size_t n = 0; n < copies.size(); n++)
+    SDL_RenderCopy(renderer, copies[n].texture, NULL, &copies[n].to);
+}
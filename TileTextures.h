@@ -0,0 +1,71 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     TileTextures.h
+ Description:   Small streaming textures for the painted canvas tiles in
+                view, reused least recently drawn first and only uploaded
+                again when their tile changes.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include "Canvas.h"
+
+#ifndef TILETEXTURES_H
+#define TILETEXTURES_H
+
+class TileTextures{
+  public:
+    TileTextures();
+    ~TileTextures();
+
+    //at most count TILE_SIZE square textures, made as tiles first need them
+    void init(SDL_Renderer * renderer, Uint32 format, int count);
+    void free();
+
+    //a texture up to date for every painted tile in canvas's view, returns
+    //pixels uploaded
+    int update(Canvas & canvas);
+
+    //one RenderCopy per painted tile in view, as of the last update
+    void draw();
+
+    size_t textures() { return all.size(); }
+
+  private:
+    struct Slot {
+      SDL_Texture * texture;
+      int tx, ty;
+      Uint64 version;       //of the tile's pixels in the texture, 0 for none
+      unsigned int frame;   //update it was last drawn in
+      Slot * newer;         //most recently drawn first
+      Slot * older;
+    };
+
+    struct Copy {
+      SDL_Texture * texture;
+      SDL_Rect to;
+    };
+
+    Slot * acquire(int tx, int ty);
+    void touch(Slot * s);
+    void unlink(Slot * s);
+
+    SDL_Renderer * renderer;
+    Uint32 format;
+    int limit;
+
+    std::unordered_map<uint64_t, Slot *> slots;
+    std::vector<Slot *> all;
+    Slot * newest;
+    Slot * oldest;
+    unsigned int frame;
+
+    std::vector<Copy> copies;
+};
+
+#endif /* TILETEXTURES_H */
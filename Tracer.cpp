@@ -0,0 +1,167 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Tracer.cpp
+ Description:   Chrome / Perfetto trace event timeline. Each thread records
+                into its own lock free buffer, the main thread writes them
+                out.
+ *****************************************************************************/
+
+#include "SDL2/include/SDL2/SDL.h"
+#include "Tracer.h"
+
+#include <cstdio>
+
+Tracer tracer;
+
+//buffer of the calling thread, set on its first event
+static thread_local void * threadBuffer = NULL;
+
+Tracer::Tracer()
+: enabled(false), file(NULL), firstEvent(true), origin(0), lastFlush(0), toMicros(0),
+  lock(NULL), dropped(0) {}
+
+Tracer::~Tracer() {
+  close();
+  for(unsigned int n = 0; n < threads.size(); n++)
+    deleteAligned(threads[n]);
+}
+
+bool Tracer::open(const std::string & path) {
+  file = fopen(path.c_str(), "w");
+  if(file == NULL)
+    return false;
+
+  if(lock == NULL)
+    lock = SDL_CreateMutex();
+
+  origin = lastFlush = SDL_GetPerformanceCounter();
+  toMicros = 1000000.0 / SDL_GetPerformanceFrequency();
+  firstEvent = true;
+
+  fprintf(file, "{\"traceEvents\":[\n");
+  enabled = true;
+  return true;
+}
+
+void Tracer::close() {
+  if(file == NULL)
+    return;
+
+  flush(true);
+  enabled = false;
+
+  fprintf(file, "\n]}\n");
+  fclose(file);
+  file = NULL;
+
+  if(dropped > 0)
+    printf("Trace dropped %u events\n", dropped.load());
+}
+
+void Tracer::begin(const char * name) {
+  if(enabled)
+    record('B', name, NULL, 0);
+}
+
+void Tracer::end(const char * name) {
+  if(enabled)
+    record('E', name, NULL, 0);
+}
+
+void Tracer::instant(const char * name, const char * arg, double value) {
+  if(enabled)
+    record('i', name, arg, value);
+}
+
+void Tracer::counter(const char * name, double value) {
+  if(enabled)
+    record('C', name, "value", value);
+}
+
+Tracer::Thread * Tracer::current() {
+  if(threadBuffer != NULL)
+    return (Thread *) threadBuffer;
+
+  //first event on this thread, register a buffer for it
+  Thread * t = newAligned<Thread>();
+
+  SDL_LockMutex(lock);
+  t->tid = threads.size() + 1;
+  char name[16];
+  snprintf(name, sizeof(name), "thread %d", t->tid);
+  t->name = name;
+  threads.push_back(t);
+  SDL_UnlockMutex(lock);
+
+  threadBuffer = t;
+  return t;
+}
+
+void Tracer::nameThread(const char * name) {
+  if(!enabled)
+    return;
+
+  Thread * t = current();
+
+  SDL_LockMutex(lock);
+  t->name = name;
+  SDL_UnlockMutex(lock);
+}
+
+void Tracer::record(char phase, const char * name, const char * arg, double value) {
+  TraceEvent e = {SDL_GetPerformanceCounter(), name, arg, value, phase};
+
+  //a full buffer loses the event rather than stalling the thread
+  if(!current()->buffer.push(e))
+    dropped++;
+}
+
+void Tracer::write(const TraceEvent & e, int tid) {
+  double ts = (e.ticks - origin) * toMicros;
+
+  fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d", 
+      firstEvent ? "" : ",\n", e.name, e.phase, ts, tid);
+  firstEvent = false;
+
+  if(e.phase == 'i')
+    fprintf(file, ",\"s\":\"t\"");
+  if(e.arg != NULL)
+    fprintf(file, ",\"args\":{\"%s\":%.17g}", e.arg, e.value);
+  fprintf(file, "}");
+}
+
+void Tracer::flush(bool force) {
+  if(file == NULL)
+    return;
+
+  Uint64 now = SDL_GetPerformanceCounter();
+  if(!force && (now - lastFlush) * toMicros < 100000)
+    return;
+  lastFlush = now;
+
+  SDL_LockMutex(lock);
+  std::vector<Thread *> all = threads;
+  SDL_UnlockMutex(lock);
+
+  for(unsigned int n = 0; n < all.size(); n++) {
+    Thread * t = all[n];
+
+    //name each thread once, the first time it shows up
+    SDL_LockMutex(lock);
+    std::string name;
+    name.swap(t->name);
+    SDL_UnlockMutex(lock);
+
+    if(!name.empty()) {
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+          "\"args\":{\"name\":\"%s\"}}", firstEvent ? "" : ",\n", t->tid, name.c_str());
+      firstEvent = false;
+    }
+
+    TraceEvent e;
+    while(t->buffer.pop(e))
+      write(e, t->tid);
+  }
+}
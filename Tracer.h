@@ -0,0 +1,80 @@
+ /*****************************************************************************
+
+                                      MyoDraw
+
+ File Name:     Tracer.h
+ Description:   Chrome / Perfetto trace event timeline. Each thread records
+                into its own lock free buffer, the main thread writes them
+                out.
+ *****************************************************************************/
+
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "RingBuffer.h"
+
+#ifndef TRACER_H
+#define TRACER_H
+
+struct TraceEvent {
+  Uint64 ticks;       //SDL performance counter
+  const char * name;  //must outlive the tracer, string literals only
+  const char * arg;   //argument name, NULL for none
+  double value;       //argument or counter value
+  char phase;         //B, E, i or C as in the trace event format
+};
+
+//per thread, about a second of events at full frame rate
+typedef RingBuffer<TraceEvent, 16384> TraceBuffer;
+
+class Tracer{
+  public:
+    Tracer();
+    ~Tracer();
+
+    bool open(const std::string & path);
+    void close();
+
+    //any thread, cheap no-ops while tracing is off
+    void begin(const char * name);
+    void end(const char * name);
+    void instant(const char * name, const char * arg, double value);
+    void counter(const char * name, double value);
+
+    //label the calling thread in the timeline
+    void nameThread(const char * name);
+
+    //main thread, writes buffered events out at most every 100 ms
+    void flush(bool force = false);
+
+    std::atomic<bool> enabled;
+
+  private:
+    struct Thread {
+      TraceBuffer buffer;
+      int tid;
+      std::string name;
+    };
+
+    void record(char phase, const char * name, const char * arg, double value);
+    Thread * current();
+    void write(const TraceEvent & e, int tid);
+
+    FILE * file;
+    bool firstEvent;
+    Uint64 origin;
+    Uint64 lastFlush;
+    double toMicros;
+
+    SDL_mutex * lock;
+    std::vector<Thread *> threads;
+    std::atomic<unsigned int> dropped;
+};
+
+extern Tracer tracer;
+
+#endif /* TRACER_H */